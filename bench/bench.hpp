@@ -0,0 +1,120 @@
+/**
+ * @file bench.hpp
+ * @brief Latency collection and result reporting shared by the benchmarks.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef BENCH_HPP
+#define BENCH_HPP
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "TleCatalog.hpp"
+
+/**
+ * @brief Summary of one benchmark, latencies in nanoseconds.
+ *
+ */
+typedef struct
+{
+    std::string name;
+    long count;
+    double median;
+    double p99;
+    double max;
+    double throughput; // calls/s
+} bench_result_t;
+
+static inline double bench_now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * @brief Random elements around the ISS line in track.hpp, for a synthetic catalog. LEO by
+ * default, `mm_min`..`mm_max` revolutions per day otherwise. Seed with srand48() for a
+ * repeatable one.
+ *
+ */
+static inline void bench_synthetic(int id, char *l1, char *l2, double mm_min = 13.5, double mm_max = 15.7)
+{
+    snprintf(l1, 70, "1 %05dU 98067A   21229.77243765  .00001431  00000-0  34209-4 0  999", id);
+    snprintf(l1 + 68, 2, "%d", TleCatalog::Checksum(l1));
+    double incl = 40 + drand48() * 60;
+    double raan = drand48() * 360;
+    int ecc = drand48() * 20000;
+    double argp = drand48() * 360;
+    double ma = drand48() * 360;
+    double mm = mm_min + drand48() * (mm_max - mm_min);
+    snprintf(l2, 70, "2 %05d %8.4f %8.4f %07d %8.4f %8.4f %11.8f%5d", id, incl, raan, ecc, argp, ma, mm, 1000);
+    snprintf(l2 + 68, 2, "%d", TleCatalog::Checksum(l2));
+}
+
+/**
+ * @brief Time `count` calls of `fn` one by one, after `warmup` untimed calls.
+ *
+ */
+template <typename F>
+bench_result_t bench_run(const char *name, long count, long warmup, F fn)
+{
+    for (long i = 0; i < warmup; i++)
+        fn(i);
+    std::vector<double> lat(count);
+    double start = bench_now();
+    for (long i = 0; i < count; i++)
+    {
+        double t = bench_now();
+        fn(i);
+        lat[i] = bench_now() - t;
+    }
+    double total = bench_now() - start;
+    std::sort(lat.begin(), lat.end());
+    bench_result_t r;
+    r.name = name;
+    r.count = count;
+    r.median = lat[count / 2];
+    r.p99 = lat[std::min<long>(count - 1, count * 99 / 100)];
+    r.max = lat[count - 1];
+    r.throughput = count / (total * 1e-9);
+    return r;
+}
+
+static inline void bench_print(const bench_result_t &r)
+{
+    printf("%-28s %9ld calls  median %10.0f ns  p99 %10.0f ns  max %10.0f ns  %12.0f /s\n",
+           r.name.c_str(), r.count, r.median, r.p99, r.max, r.throughput);
+}
+
+/**
+ * @brief Write results as a JSON document, one object per benchmark.
+ *
+ * @return int 1 on success, -1 if the file cannot be written.
+ */
+static inline int bench_save(const char *fname, const char *suite, const std::vector<bench_result_t> &results)
+{
+    FILE *fp = fopen(fname, "w");
+    if (fp == NULL)
+        return -1;
+    fprintf(fp, "{\n  \"suite\": \"%s\",\n  \"time\": %ld,\n  \"unit\": \"ns\",\n  \"results\": [\n", suite, (long)time(NULL));
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const bench_result_t &r = results[i];
+        fprintf(fp, "    {\"name\": \"%s\", \"count\": %ld, \"median\": %.1f, \"p99\": %.1f, \"max\": %.1f, \"throughput\": %.1f}%s\n",
+                r.name.c_str(), r.count, r.median, r.p99, r.max, r.throughput, i + 1 < results.size() ? "," : "");
+    }
+    fprintf(fp, "  ]\n}\n");
+    fclose(fp);
+    return 1;
+}
+
+#endif // BENCH_HPP
@@ -0,0 +1,129 @@
+/**
+ * @file bench_batch_look.cpp
+ * @brief Throughput and agreement of the batch look angles against Observer::GetLookAngle.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * Usage: bench_batch_look.out [states]
+ * Two layouts: a catalog of BENCH_CATALOG_SIZE LEO objects at one time, and the default TLE
+ * sampled every second for `states` seconds. States come from BatchSGP4, so only the look
+ * angles are timed.
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+#include <SGP4/Observer.h>
+#include <SGP4/SGP4.h>
+#include <SGP4/Tle.h>
+#include "BatchLook.hpp"
+#include "BatchSGP4.hpp"
+#include "bench.hpp"
+#include "track.hpp"
+
+#define BENCH_CATALOG_SIZE 25000
+#define BENCH_STATES 86400 // one day at one second
+#define BENCH_REPEAT 20
+#define BENCH_LAT 42.65578686304611
+#define BENCH_LON -71.32546893568428
+#define BENCH_ALT 0.008 // km
+
+typedef struct
+{
+    double az, el, range, range_rate;
+} deviation_t;
+
+/**
+ * @brief Look angles of lane i at times[i] (or at times[0] when `same`), scalar and batch,
+ * returning the throughput of each and the worst disagreement.
+ *
+ */
+static void run(const char *name, const batch_state_t &in, const std::vector<DateTime> &times, bool same, deviation_t &dev, bool &ok)
+{
+    const CoordGeodetic loc(BENCH_LAT, BENCH_LON, BENCH_ALT);
+    Observer obs(loc);
+    BatchLook batch(loc);
+    size_t n = in.x.size();
+
+    std::vector<CoordTopocentric> ref(n);
+    double start = bench_now();
+    for (int r = 0; r < BENCH_REPEAT; r++)
+        for (size_t i = 0; i < n; i++)
+        {
+            const DateTime &dt = times[same ? 0 : i];
+            Eci eci(dt, Vector(in.x[i], in.y[i], in.z[i]), Vector(in.vx[i], in.vy[i], in.vz[i]));
+            ref[i] = obs.GetLookAngle(eci);
+        }
+    double scalar_rate = (double)n * BENCH_REPEAT / ((bench_now() - start) * 1e-9);
+
+    batch_look_t out;
+    start = bench_now();
+    for (int r = 0; r < BENCH_REPEAT; r++)
+    {
+        if (same)
+            batch.Compute(in, times[0], out);
+        else
+            batch.Compute(in, times.data(), out);
+    }
+    double batch_rate = (double)n * BENCH_REPEAT / ((bench_now() - start) * 1e-9);
+
+    dev = {0, 0, 0, 0};
+    for (size_t i = 0; i < n; i++)
+    {
+        if (in.status[i] <= 0)
+            continue;
+        double daz = fabs(out.az[i] - ref[i].azimuth);
+        daz = daz > M_PI ? 2 * M_PI - daz : daz; // across north
+        dev.az = fmax(dev.az, daz);
+        dev.el = fmax(dev.el, fabs(out.el[i] - ref[i].elevation));
+        dev.range = fmax(dev.range, fabs(out.range[i] - ref[i].range));
+        dev.range_rate = fmax(dev.range_rate, fabs(out.range_rate[i] - ref[i].range_rate));
+    }
+    ok = (dev.az <= BATCH_LOOK_ANGLE_TOL) && (dev.el <= BATCH_LOOK_ANGLE_TOL) && (dev.range <= BATCH_LOOK_RANGE_TOL) && (dev.range_rate <= BATCH_LOOK_RATE_TOL);
+
+    printf("%s, %zu states\n", name, n);
+    printf("  max deviation: az %.2e rad, el %.2e rad, range %.2e km, range rate %.2e km/s%s\n",
+           dev.az, dev.el, dev.range, dev.range_rate, ok ? "" : "  OUT OF TOLERANCE");
+    printf("  %-26s %14.0f states/s\n", "Observer::GetLookAngle", scalar_rate);
+    printf("  %-26s %14.0f states/s (%.1fx)\n", "BatchLook::Compute", batch_rate, batch_rate / scalar_rate);
+}
+
+int main(int argc, char *argv[])
+{
+    int nstates = argc > 1 ? atoi(argv[1]) : BENCH_STATES;
+    if (nstates <= 0)
+        nstates = BENCH_STATES;
+    printf("tolerance: %.0e rad, %.0e km, %.0e km/s\n", BATCH_LOOK_ANGLE_TOL, BATCH_LOOK_RANGE_TOL, BATCH_LOOK_RATE_TOL);
+
+    // many objects, one time
+    BatchSGP4 catalog;
+    srand48(42);
+    char l1[70], l2[70];
+    for (int i = 0; i < BENCH_CATALOG_SIZE; i++)
+    {
+        bench_synthetic(10000 + i, l1, l2);
+        catalog.Add(Tle(l1, l2));
+    }
+    Tle tle(DEFAULT_TLE1, DEFAULT_TLE2);
+    std::vector<DateTime> times(1, tle.Epoch().AddMinutes(90));
+    batch_state_t in;
+    catalog.Propagate(times[0], in, 1);
+    deviation_t dev;
+    bool ok_objects, ok_series;
+    run("objects x 1 time", in, times, true, dev, ok_objects);
+
+    // one object, many times
+    BatchSGP4 single;
+    single.Add(tle);
+    times.resize(nstates);
+    for (int i = 0; i < nstates; i++)
+        times[i] = tle.Epoch().AddSeconds(i);
+    single.PropagateTimes(0, times.data(), nstates, in, 1);
+    run("1 object x times", in, times, false, dev, ok_series);
+
+    return ok_objects && ok_series ? 0 : 1;
+}
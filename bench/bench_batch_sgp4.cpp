@@ -0,0 +1,173 @@
+/**
+ * @file bench_batch_sgp4.cpp
+ * @brief Throughput of the batch propagator against SGP4::FindPosition, in objects x epochs/s.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * Usage: bench_batch_sgp4.out [TLE file] [epochs]
+ * Without a file (or with an empty name), a synthetic catalog of BENCH_CATALOG_SIZE objects is
+ * generated, BENCH_DEEP_COUNT of them deep-space. Agreement is checked at every offset in
+ * probe_min, out to the week BatchSGP4.hpp promises.
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <exception>
+#include <string>
+#include <vector>
+#include <SGP4/SGP4.h>
+#include <SGP4/Tle.h>
+#include "BatchSGP4.hpp"
+#include "bench.hpp"
+
+#define BENCH_CATALOG_SIZE 25000
+#define BENCH_DEEP_COUNT 250 // of the synthetic catalog, periods of 4 to 24 hours
+#define BENCH_EPOCHS 1440 // one day at one minute
+
+static int load(const char *fname, std::vector<Tle> &tles)
+{
+    FILE *fp = fopen(fname, "r");
+    if (fp == NULL)
+        return -1;
+    char a[128], b[128];
+    while (fgets(a, sizeof(a), fp) != NULL)
+    {
+        if (a[0] != '1')
+            continue;
+        if (fgets(b, sizeof(b), fp) == NULL)
+            break;
+        a[strcspn(a, "\r\n")] = '\0';
+        b[strcspn(b, "\r\n")] = '\0';
+        try
+        {
+            tles.push_back(Tle(a, b));
+        }
+        catch (std::exception &e)
+        {
+        }
+    }
+    fclose(fp);
+    return tles.size();
+}
+
+int main(int argc, char *argv[])
+{
+    std::vector<Tle> tles;
+    if ((argc > 1) && (argv[1][0] != '\0'))
+    {
+        if (load(argv[1], tles) <= 0)
+        {
+            fprintf(stderr, "Could not read TLEs from %s\n", argv[1]);
+            return -1;
+        }
+    }
+    else
+    {
+        srand48(42);
+        char l1[70], l2[70];
+        for (int i = 0; i < BENCH_CATALOG_SIZE; i++)
+        {
+            if (i < BENCH_CATALOG_SIZE - BENCH_DEEP_COUNT)
+                bench_synthetic(10000 + i, l1, l2);
+            else
+                bench_synthetic(10000 + i, l1, l2, 1.0, 6.0);
+            tles.push_back(Tle(l1, l2));
+        }
+    }
+    int epochs = argc > 2 ? atoi(argv[2]) : BENCH_EPOCHS;
+
+    BatchSGP4 batch;
+    std::vector<SGP4 *> scalar;
+    for (size_t i = 0; i < tles.size(); i++)
+        if (batch.Add(tles[i]) >= 0)
+            scalar.push_back(new SGP4(tles[i]));
+    size_t n = batch.Size();
+    int ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    DateTime t0 = tles[0].Epoch();
+    printf("%zu objects, %d epochs, %d CPUs\n", n, epochs, ncpu);
+
+    // scalar reference and agreement, across the catalog at each probe offset
+    const double probe_min[] = {0, 90, 300, 1440, 4320, 10080}; // minutes from epoch, 300 past the deep-space period split
+    const int nprobes = sizeof(probe_min) / sizeof(probe_min[0]);
+    std::vector<double> rx(n), ry(n), rz(n), rvx(n), rvy(n), rvz(n);
+    batch_state_t out;
+    double max_dp = 0, max_dv = 0, worst_min = 0, scalar_time = 0;
+    int compared = 0;
+    for (int p = 0; p < nprobes; p++)
+    {
+        DateTime probe = t0.AddMinutes(probe_min[p]);
+        double start = bench_now();
+        for (size_t i = 0; i < n; i++)
+        {
+            try
+            {
+                Eci eci = scalar[i]->FindPosition(probe);
+                rx[i] = eci.Position().x;
+                ry[i] = eci.Position().y;
+                rz[i] = eci.Position().z;
+                rvx[i] = eci.Velocity().x;
+                rvy[i] = eci.Velocity().y;
+                rvz[i] = eci.Velocity().z;
+            }
+            catch (std::exception &e)
+            {
+                rx[i] = NAN;
+            }
+        }
+        scalar_time += bench_now() - start;
+
+        batch.Propagate(probe, out, 1);
+        for (size_t i = 0; i < n; i++)
+        {
+            if ((out.status[i] <= 0) || isnan(rx[i]))
+                continue;
+            double dp = sqrt(pow(out.x[i] - rx[i], 2) + pow(out.y[i] - ry[i], 2) + pow(out.z[i] - rz[i], 2));
+            double dv = sqrt(pow(out.vx[i] - rvx[i], 2) + pow(out.vy[i] - rvy[i], 2) + pow(out.vz[i] - rvz[i], 2));
+            if (dp > max_dp)
+                worst_min = probe_min[p];
+            max_dp = dp > max_dp ? dp : max_dp;
+            max_dv = dv > max_dv ? dv : max_dv;
+            compared++;
+        }
+    }
+    double scalar_rate = (double)n * nprobes / (scalar_time * 1e-9);
+
+    // many objects, one epoch at a time
+    std::vector<DateTime> times(epochs);
+    for (int k = 0; k < epochs; k++)
+        times[k] = t0.AddMinutes(k);
+    int threads[2] = {1, ncpu};
+    double objects_rate[2], epochs_rate[2];
+    for (int t = 0; t < 2; t++)
+    {
+        double start = bench_now();
+        for (int k = 0; k < epochs; k++)
+            batch.Propagate(times[k], out, threads[t]);
+        objects_rate[t] = (double)n * epochs / ((bench_now() - start) * 1e-9);
+
+        // one object, many epochs
+        start = bench_now();
+        for (size_t i = 0; i < n; i++)
+            batch.PropagateTimes(i, times.data(), epochs, out, threads[t]);
+        epochs_rate[t] = (double)n * epochs / ((bench_now() - start) * 1e-9);
+    }
+
+    printf("max deviation from SGP4::FindPosition: %.3e km (at %.0f min), %.3e km/s over %d states at %d offsets up to %.0f min (tolerance %.0e km, %.0e km/s)\n",
+           max_dp, worst_min, max_dv, compared, nprobes, probe_min[nprobes - 1], BATCH_SGP4_POS_TOL, BATCH_SGP4_VEL_TOL);
+    printf("%-36s %14.0f objects*epochs/s\n", "SGP4::FindPosition", scalar_rate);
+    for (int t = 0; t < 2; t++)
+    {
+        printf("batch, objects x 1 epoch, %2d thread%s %14.0f objects*epochs/s (%.1fx)\n", threads[t], threads[t] > 1 ? "s" : " ", objects_rate[t], objects_rate[t] / scalar_rate);
+        printf("batch, 1 object x epochs, %2d thread%s %14.0f objects*epochs/s (%.1fx)\n", threads[t], threads[t] > 1 ? "s" : " ", epochs_rate[t], epochs_rate[t] / scalar_rate);
+    }
+
+    for (size_t i = 0; i < scalar.size(); i++)
+        delete scalar[i];
+    return (max_dp > BATCH_SGP4_POS_TOL) || (max_dv > BATCH_SGP4_VEL_TOL) ? 1 : 0;
+}
@@ -0,0 +1,143 @@
+/**
+ * @file bench_sched.cpp
+ * @brief Latency of incremental rescheduling, and a check that rescheduling never gives one
+ * pass two windows.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * Usage: bench_sched.out [results.json]
+ * Exits with 1 if the timeline is inconsistent after any update.
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include "PassScheduler.hpp"
+#include "bench.hpp"
+
+#define BENCH_TARGETS 50
+#define BENCH_PASSES 16 // per target, as PASS_PLAN_COUNT
+#define BENCH_UPDATES 2000
+#define BENCH_RESULTS "bench_sched_results.json"
+
+/**
+ * @brief Look angles that only depend on time, enough for the slew margins.
+ *
+ */
+static int look(void *ctx, int target, const DateTime &dt, CoordTopocentric *coord)
+{
+    double t = dt.Ticks() * 1e-6;
+    coord->azimuth = fmod(t * 1e-3 + target, 2 * M_PI);
+    coord->elevation = 0.5;
+    coord->range = 1000;
+    coord->range_rate = 0;
+    return 1;
+}
+
+static pass_t make_pass(const DateTime &t0, double aos, double los)
+{
+    pass_t p;
+    p.aos = t0.AddSeconds(aos);
+    p.los = t0.AddSeconds(los);
+    p.tca = t0.AddSeconds((aos + los) / 2);
+    p.max_el = 0.5;
+    p.aos_az = p.los_az = 0;
+    return p;
+}
+
+/**
+ * @brief Windows sorted and disjoint, and at most one per pass.
+ *
+ */
+static bool consistent(const PassScheduler &sched, const char *name)
+{
+    const std::vector<sched_entry_t> &tl = sched.Timeline();
+    for (size_t i = 0; i < tl.size(); i++)
+    {
+        if ((i > 0) && (tl[i].start < tl[i - 1].end))
+        {
+            printf("%s: windows %zu and %zu overlap\n", name, i - 1, i);
+            return false;
+        }
+        for (size_t j = i + 1; j < tl.size(); j++)
+            if ((tl[i].target == tl[j].target) && (tl[i].pass.aos == tl[j].pass.aos))
+            {
+                printf("%s: target %d has two windows for one pass\n", name, tl[i].target);
+                return false;
+            }
+    }
+    return true;
+}
+
+/**
+ * @brief A trimmed window left of a pass that moves away. The moved pass frees the rest of the
+ * trimmed pass, which used to be placed again next to its surviving window.
+ *
+ */
+static bool regression(double settle)
+{
+    rotator_limits_t limits = {ROTATOR_AZ_RATE, ROTATOR_EL_RATE, settle};
+    PassScheduler sched(look, NULL);
+    sched.SetLimits(limits);
+    DateTime t0(2026, 1, 1, 0, 0, 0);
+    std::vector<pass_t> a(1, make_pass(t0, 100, 700));
+    std::vector<pass_t> c(1, make_pass(t0, 300, 900));
+    sched.SetPasses(1, 1, a);
+    sched.SetPasses(3, 2, c); // takes [300, 900], cuts target 1 short
+    c[0] = make_pass(t0, 750, 1000);
+    sched.SetPasses(3, 2, c);
+    char name[64];
+    snprintf(name, sizeof(name), "regression, settle %.0f s", settle);
+    return consistent(sched, name);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *fname = argc > 1 ? argv[1] : BENCH_RESULTS;
+    bool ok = regression(0);
+    ok = regression(10) && ok;
+
+    // many targets with overlapping passes, each update moves one target's passes a little
+    PassScheduler sched(look, NULL);
+    DateTime t0(2026, 1, 1, 0, 0, 0);
+    srand48(42);
+    std::vector<std::vector<pass_t>> passes(BENCH_TARGETS);
+    for (int i = 0; i < BENCH_TARGETS; i++)
+    {
+        for (int j = 0; j < BENCH_PASSES; j++)
+        {
+            double aos = drand48() * 86400;
+            passes[i].push_back(make_pass(t0, aos, aos + 300 + drand48() * 600));
+        }
+        sched.SetPasses(i + 1, i % 3, passes[i]);
+    }
+    ok = ok && consistent(sched, "initial timeline");
+    auto update = [&](long i) {
+        int k = i % BENCH_TARGETS;
+        pass_t &p = passes[k][i % BENCH_PASSES];
+        double shift = drand48() * 120 - 60;
+        p = make_pass(t0, (p.aos - t0).TotalSeconds() + shift, (p.los - t0).TotalSeconds() + shift);
+        sched.SetPasses(k + 1, k % 3, passes[k]);
+    };
+    for (long i = 0; (i < BENCH_UPDATES) && ok; i++)
+    {
+        update(i);
+        ok = consistent(sched, "after update");
+    }
+    std::vector<bench_result_t> results;
+    results.push_back(bench_run("PassScheduler::SetPasses", BENCH_UPDATES, 0, update));
+
+    for (size_t i = 0; i < results.size(); i++)
+        bench_print(results[i]);
+    printf("timeline: %zu windows, %s\n", sched.Timeline().size(), ok ? "consistent" : "INCONSISTENT");
+    if (bench_save(fname, "sched", results) < 0)
+    {
+        fprintf(stderr, "Could not write %s\n", fname);
+        return -1;
+    }
+    printf("Results saved to %s\n", fname);
+    return ok ? 0 : 1;
+}
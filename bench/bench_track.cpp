@@ -0,0 +1,152 @@
+/**
+ * @file bench_track.cpp
+ * @brief Latency of the real-time tracking path: propagation, look angles, a full tick and the
+ * network frame path.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * Usage: bench_track.out [results.json]
+ * The motor is opened on a pseudo-terminal, frames go through a local socket pair.
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+#include <SGP4/Observer.h>
+#include <SGP4/SGP4.h>
+#include <SGP4/Tle.h>
+#include "TargetSystem.hpp"
+#include "Telemetry.hpp"
+#include "track.hpp"
+#include "network.hpp"
+#include "bench.hpp"
+
+#define BENCH_COUNT 100000
+#define BENCH_TICKS 20000
+#define BENCH_FRAMES 20000
+#define BENCH_RESULTS "bench_results.json"
+#define BENCH_LAT 42.65578686304611
+#define BENCH_LON -71.32546893568428
+#define BENCH_ALT 0.008 // km
+
+static volatile bool draining = true;
+
+/**
+ * @brief Read and discard everything the motor writes, like a rotator that never talks back.
+ *
+ */
+static void *drain_pty(void *p)
+{
+    int fd = *(int *)p;
+    char buf[256];
+    while (draining)
+        if (read(fd, buf, sizeof(buf)) <= 0)
+            usleep(1000);
+    return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *fname = argc > 1 ? argv[1] : BENCH_RESULTS;
+    std::vector<bench_result_t> results;
+
+    Tle tle(DEFAULT_TLE1, DEFAULT_TLE2);
+    SGP4 sgp(tle);
+    Observer obs(BENCH_LAT, BENCH_LON, BENCH_ALT);
+    DateTime t0 = DateTime::Now(true);
+
+    results.push_back(bench_run("SGP4::FindPosition", BENCH_COUNT, 1000, [&](long i) {
+        Eci eci = sgp.FindPosition(t0.AddSeconds(i * 0.1));
+        (void)eci;
+    }));
+
+    Eci eci = sgp.FindPosition(t0);
+    results.push_back(bench_run("Observer::GetLookAngle", BENCH_COUNT, 1000, [&](long i) {
+        CoordTopocentric coord = obs.GetLookAngle(eci);
+        (void)coord;
+    }));
+
+    // full tick, motor on a pseudo-terminal
+    int master = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if ((master < 0) || (grantpt(master) < 0) || (unlockpt(master) < 0))
+    {
+        fprintf(stderr, "Could not open a pseudo-terminal for the motor\n");
+        return -1;
+    }
+    pthread_t drain_tid;
+    pthread_create(&drain_tid, NULL, drain_pty, &master);
+    {
+        TargetSystem tsys;
+        if (tsys.Create(ptsname(master), DEFAULT_TLE1, DEFAULT_TLE2, BENCH_LAT, BENCH_LON, BENCH_ALT) < 0)
+        {
+            fprintf(stderr, "Could not create the target system\n");
+            return -1;
+        }
+        std::vector<sched_entry_t> schedule;
+        for (int i = 0; (i < 100) && (tsys.GetSchedule(schedule) == 0); i++) // let the planner run once
+            usleep(100000);
+        telem_sample_t drained[64];
+        results.push_back(bench_run("TargetSystem::Track", BENCH_TICKS, 100, [&](long i) {
+            tsys.Track();
+            if ((i & 63) == 0) // keep the telemetry ring from filling up, as the sender would
+                while (tsys.ReadTelemetry(drained, 64) > 0)
+                    ;
+        }));
+    }
+    draining = false;
+    pthread_join(drain_tid, NULL);
+    close(master);
+
+    // network frame path
+    unsigned char payload[NETWORK_FRAME_MAX_PAYLOAD_SIZE];
+    int batch = TelemetryRing::BatchMax(sizeof(payload));
+    std::vector<telem_sample_t> samples(batch); // a full frame, as gs_telemetry_thread sends
+    int payload_size = TelemetryRing::Pack(samples.data(), batch, 0, payload, sizeof(payload));
+    results.push_back(bench_run("TelemetryRing::Pack", BENCH_COUNT, 1000, [&](long i) {
+        TelemetryRing::Pack(samples.data(), batch, 0, payload, sizeof(payload));
+    }));
+    results.push_back(bench_run("NetFrame encode", BENCH_FRAMES, 100, [&](long i) {
+        NetFrame frame(payload, payload_size, NetType::TRACKING_DATA, NetVertex::CLIENT);
+    }));
+
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) < 0)
+    {
+        fprintf(stderr, "Could not create a socket pair\n");
+        return -1;
+    }
+    NetDataClient *tx = new NetDataClient(NetPort::TRACK, SERVER_POLL_RATE);
+    NetDataClient *rx = new NetDataClient(NetPort::TRACK, SERVER_POLL_RATE);
+    tx->socket = sv[0];
+    rx->socket = sv[1];
+    tx->connection_ready = rx->connection_ready = true;
+    tx->recv_active = rx->recv_active = true;
+    NetFrame inframe;
+    unsigned char received[NETWORK_FRAME_MAX_PAYLOAD_SIZE];
+    results.push_back(bench_run("NetFrame send+recv+decode", BENCH_FRAMES, 100, [&](long i) {
+        NetFrame frame(payload, payload_size, NetType::TRACKING_DATA, NetVertex::CLIENT);
+        frame.sendFrame(tx);
+        if (inframe.recvFrame(rx) >= 0)
+            inframe.retrievePayload(received, inframe.getPayloadSize());
+    }));
+    close(sv[0]);
+    close(sv[1]);
+
+    for (size_t i = 0; i < results.size(); i++)
+        bench_print(results[i]);
+    if (bench_save(fname, "track", results) < 0)
+    {
+        fprintf(stderr, "Could not write %s\n", fname);
+        return -1;
+    }
+    printf("Results saved to %s\n", fname);
+    return 0;
+}
@@ -0,0 +1,94 @@
+/**
+ * @file BatchLook.hpp
+ * @brief Structure-of-arrays look angles: azimuth, elevation, range and range rate of many ECI
+ * states from one station.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * Same model as Observer::GetLookAngle, with the station's geodetic terms computed once instead
+ * of on every call. Only the sidereal time depends on the sample, so a time series or a whole
+ * catalog goes through a single vectorized loop (src/BatchLook.cpp, built like BatchSGP4 with
+ * -ffast-math for libmvec and AVX2 clones). Input comes in the layout BatchSGP4 produces.
+ *
+ * Agreement with Observer::GetLookAngle: within BATCH_LOOK_ANGLE_TOL in azimuth and elevation,
+ * BATCH_LOOK_RANGE_TOL in range and BATCH_LOOK_RATE_TOL in range rate. Most of it is libsgp4's
+ * sidereal time, which rounds to ~2e-9 rad through the Julian date (the station moves ~1e-5 km);
+ * azimuth near the zenith magnifies that.
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef BATCH_LOOK_HPP
+#define BATCH_LOOK_HPP
+
+#include <BatchSGP4.hpp>
+#include <SGP4/CoordGeodetic.h>
+#include <SGP4/DateTime.h>
+#include <vector>
+
+#define BATCH_LOOK_ANGLE_TOL 1e-6 // radians
+#define BATCH_LOOK_RANGE_TOL 1e-4 // km
+#define BATCH_LOOK_RATE_TOL 1e-6  // km/s
+
+/**
+ * @brief Look angles, one lane per input state. Angles in radians, azimuth in [0, 2pi), range
+ * in km, range rate in km/s, as in CoordTopocentric.
+ *
+ */
+typedef struct
+{
+    std::vector<double> az, el, range, range_rate;
+} batch_look_t;
+
+class BatchLook
+{
+public:
+    /**
+     * @brief Station terms that do not change with time.
+     *
+     */
+    typedef struct
+    {
+        double lon;     // radians
+        double sin_lat;
+        double cos_lat;
+        double axial;   // km, distance from the earth's axis
+        double polar;   // km, distance from the equatorial plane
+    } station_t;
+
+private:
+    station_t st;
+
+public:
+    BatchLook(const CoordGeodetic &location)
+    {
+        SetLocation(location);
+    }
+
+    void SetLocation(const CoordGeodetic &location);
+
+    /**
+     * @brief Look angles of every lane of `in` at `dt`, e.g. a catalog from BatchSGP4::Propagate.
+     *
+     * @return int Number of lanes.
+     */
+    int Compute(const batch_state_t &in, const DateTime &dt, batch_look_t &out) const;
+
+    /**
+     * @brief Look angles of lane i of `in` at times[i], e.g. a time series from
+     * BatchSGP4::PropagateTimes.
+     *
+     * @return int Number of lanes.
+     */
+    int Compute(const batch_state_t &in, const DateTime *times, batch_look_t &out) const;
+
+    /**
+     * @brief The vector kernel on lanes [lo, hi). `theta` is the station's local mean sidereal
+     * time, one per lane; `out` must already be sized.
+     *
+     */
+    static void Kernel(const station_t &st, const batch_state_t &in, const double *theta, size_t lo, size_t hi, batch_look_t &out);
+};
+
+#endif // BATCH_LOOK_HPP
@@ -0,0 +1,157 @@
+/**
+ * @file BatchSGP4.hpp
+ * @brief Structure-of-arrays SGP4 propagator for whole element catalogs.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * Near-earth objects (period below 225 minutes) are propagated by a vectorizable copy of the
+ * SGP4 near-earth model, compiled with AVX2 and generic clones in src/BatchSGP4.cpp (built with
+ * -ffast-math so the transcendentals resolve to libmvec). Deep-space objects fall back to
+ * libsgp4's SGP4::FindPosition one at a time.
+ *
+ * Agreement with SGP4::FindPosition: within BATCH_SGP4_POS_TOL km in position and
+ * BATCH_SGP4_VEL_TOL km/s in velocity up to a week from epoch, as bench_batch_sgp4 checks. The
+ * difference comes from the vector math library and the fixed Kepler iteration count, not from
+ * the model.
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef BATCH_SGP4_HPP
+#define BATCH_SGP4_HPP
+
+#include <SGP4/SGP4.h>
+#include <SGP4/Tle.h>
+#include <stdint.h>
+#include <vector>
+
+#define BATCH_SGP4_POS_TOL 1e-6 // km
+#define BATCH_SGP4_VEL_TOL 1e-9 // km/s
+#define BATCH_SGP4_KEPLER_ITER 10
+#define BATCH_SGP4_BLOCK 256 // lanes per block of the kernel's scratch arrays
+#define BATCH_SGP4_DEEP_PERIOD 225.0 // minutes, longer periods need the deep-space model
+
+/**
+ * @brief Mean elements as they appear in a TLE, angles in radians.
+ *
+ */
+typedef struct
+{
+    int id;              // NORAD ID
+    int64_t epoch;       // DateTime ticks
+    double inclination;  // radians
+    double raan;         // radians
+    double eccentricity;
+    double arg_perigee;  // radians
+    double mean_anomaly; // radians
+    double mean_motion;  // revolutions/day
+    double bstar;
+} tle_elements_t;
+
+/**
+ * @brief Propagation results, one lane per object or per epoch. Positions in km, velocities in
+ * km/s, TEME frame like libsgp4's Eci.
+ *
+ */
+typedef struct
+{
+    std::vector<double> x, y, z;
+    std::vector<double> vx, vy, vz;
+    std::vector<int> status; // 1 ok, -1 invalid orbit or decayed, -2 deep space propagation failed
+} batch_state_t;
+
+class BatchSGP4
+{
+public:
+    /**
+     * @brief Per-object constants of the near-earth model, one array per term.
+     *
+     */
+    typedef struct
+    {
+        std::vector<double> xmo, omegao, xnodeo, eo, xincl, bstar;
+        std::vector<double> xnodp, aodp, cosio, sinio, x3thm1, x1mth2, x7thm1;
+        std::vector<double> xlcof, aycof, c1, c4, c5, xmdot, omgdot, xnodot, xnodcf;
+        std::vector<double> t2cof, t3cof, t4cof, t5cof, omgcof, xmcof, eta, delmo, sinmo, d2, d3, d4;
+        std::vector<double> simple; // 1.0 below 220 km perigee, truncated drag terms
+    } soa_t;
+
+private:
+    soa_t el;
+    std::vector<int> ids;
+    std::vector<int64_t> epochs;
+    std::vector<SGP4 *> deep; // non-null for objects propagated by libsgp4
+
+    int init(const tle_elements_t &e, SGP4 *fallback);
+    void fallback(size_t obj, const double *tsince, size_t lo, size_t hi, bool same_object, batch_state_t &out) const;
+
+public:
+    BatchSGP4() {}
+    ~BatchSGP4();
+    BatchSGP4(const BatchSGP4 &) = delete;
+    BatchSGP4 &operator=(const BatchSGP4 &) = delete;
+
+    /**
+     * @brief Convert a parsed TLE to the element layout used here.
+     *
+     */
+    static tle_elements_t Elements(const Tle &tle);
+
+    /**
+     * @brief Add one object.
+     *
+     * @return int Index of the object, -1 on invalid elements.
+     */
+    int Add(const Tle &tle);
+
+    /**
+     * @brief Add one object from bare elements.
+     *
+     * @return int Index of the object, -1 on invalid elements, -2 for deep-space orbits, which
+     * need the TLE text for the libsgp4 fallback.
+     */
+    int Add(const tle_elements_t &e);
+
+    void Clear();
+
+    size_t Size() const
+    {
+        return ids.size();
+    }
+
+    int Id(size_t idx) const
+    {
+        return ids[idx];
+    }
+
+    /**
+     * @brief Propagate every object to `dt`.
+     *
+     * @param nthreads Worker threads, 0 for one per online CPU.
+     * @return int Number of objects propagated successfully.
+     */
+    int Propagate(const DateTime &dt, batch_state_t &out, int nthreads = 0) const;
+
+    /**
+     * @brief Propagate object `idx` to each of `count` epochs.
+     *
+     * @return int Number of epochs propagated successfully, -1 if idx is out of range.
+     */
+    int PropagateTimes(size_t idx, const DateTime *times, size_t count, batch_state_t &out, int nthreads = 0) const;
+
+    /**
+     * @brief Propagate lanes [lo, hi) of `out`. Objects are indexed by lane unless `obj` is
+     * non-negative, in which case every lane uses object `obj`. `out` must already be sized.
+     *
+     */
+    void Run(long obj, const double *tsince, size_t lo, size_t hi, batch_state_t &out) const;
+
+    /**
+     * @brief The near-earth vector kernel alone, without the deep-space fallback.
+     *
+     */
+    static void Kernel(const soa_t &el, long obj, const double *tsince, size_t lo, size_t hi, batch_state_t &out);
+};
+
+#endif // BATCH_SGP4_HPP
@@ -0,0 +1,47 @@
+/**
+ * @file Doppler.hpp
+ * @brief Doppler shifts of the radio links from the range rate of the target.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * The range rate comes from the pass table on every tick, so tuning the radios costs no
+ * propagation. Range rate is positive when the target moves away.
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef DOPPLER_HPP
+#define DOPPLER_HPP
+
+#define DOPPLER_C 299792.458 // km/s
+
+/**
+ * @brief Link frequencies to correct for, 0 if the link is not used.
+ *
+ */
+typedef struct
+{
+    double uplink;   // Hz, what the target should receive
+    double downlink; // Hz, what the target transmits
+} radio_freq_t;
+
+/**
+ * @brief Offset of the received downlink from `freq`, in Hz.
+ *
+ */
+static inline double doppler_downlink(double freq, double range_rate)
+{
+    return -freq * range_rate / (DOPPLER_C + range_rate);
+}
+
+/**
+ * @brief Offset to add to the transmitted uplink so the target receives `freq`, in Hz.
+ *
+ */
+static inline double doppler_uplink(double freq, double range_rate)
+{
+    return freq * range_rate / (DOPPLER_C - range_rate);
+}
+
+#endif // DOPPLER_HPP
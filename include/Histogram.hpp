@@ -0,0 +1,146 @@
+/**
+ * @file Histogram.hpp
+ * @brief Log-linear latency histogram in the style of HdrHistogram, recorded without locks.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * Values are nanoseconds. Below 32 ns every value has its own bucket; above that each power of
+ * two is split into 16 buckets, so a reported value is within 6.25% of the recorded one. Values
+ * beyond 2^40 ns (about 18 minutes) land in the last bucket.
+ *
+ * Counters are sharded: each recording thread picks a shard once and increments it with relaxed
+ * atomics, and readers sum the shards.
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef HISTOGRAM_HPP
+#define HISTOGRAM_HPP
+
+#include <atomic>
+#include <stdint.h>
+#include <string.h>
+
+#define HIST_LINEAR 32   // values recorded exactly
+#define HIST_SUB 16      // buckets per power of two above HIST_LINEAR
+#define HIST_MAX_BITS 40 // largest value tracked, 2^40 ns
+#define HIST_BUCKETS (HIST_LINEAR + (HIST_MAX_BITS - 5) * HIST_SUB + 1) // last one is the overflow
+#define HIST_SHARDS 4
+
+/**
+ * @brief Summary of a histogram or of the difference between two reads. Values in nanoseconds.
+ *
+ */
+typedef struct
+{
+    uint64_t count;
+    double p50;
+    double p90;
+    double p99;
+    double p999;
+    double max;
+} hist_stats_t;
+
+class Histogram
+{
+private:
+    typedef struct
+    {
+        std::atomic<uint64_t> counts[HIST_BUCKETS];
+    } shard_t;
+
+    shard_t shards[HIST_SHARDS];
+
+    static int shard()
+    {
+        static std::atomic<int> next(0);
+        thread_local int id = next.fetch_add(1) % HIST_SHARDS;
+        return id;
+    }
+
+public:
+    Histogram()
+    {
+        for (int s = 0; s < HIST_SHARDS; s++)
+            for (int i = 0; i < HIST_BUCKETS; i++)
+                shards[s].counts[i].store(0, std::memory_order_relaxed);
+    }
+
+    Histogram(const Histogram &) = delete;
+    Histogram &operator=(const Histogram &) = delete;
+
+    static int Bucket(uint64_t v)
+    {
+        if (v < HIST_LINEAR)
+            return v;
+        int msb = 63 - __builtin_clzll(v);
+        if (msb >= HIST_MAX_BITS)
+            return HIST_BUCKETS - 1;
+        int shift = msb - 4; // keep the top five bits, 16..31
+        return HIST_LINEAR + (shift - 1) * HIST_SUB + (int)((v >> shift) - HIST_SUB);
+    }
+
+    /**
+     * @brief Largest value that lands in bucket `idx`.
+     *
+     */
+    static uint64_t Upper(int idx)
+    {
+        if (idx < HIST_LINEAR)
+            return idx;
+        int k = idx - HIST_LINEAR;
+        int shift = k / HIST_SUB + 1;
+        uint64_t sub = k % HIST_SUB + HIST_SUB;
+        return ((sub + 1) << shift) - 1;
+    }
+
+    void Record(uint64_t ns)
+    {
+        shards[shard()].counts[Bucket(ns)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Sum the shards into `counts`, HIST_BUCKETS entries.
+     *
+     */
+    void Merge(uint64_t *counts) const
+    {
+        memset(counts, 0x0, HIST_BUCKETS * sizeof(uint64_t));
+        for (int s = 0; s < HIST_SHARDS; s++)
+            for (int i = 0; i < HIST_BUCKETS; i++)
+                counts[i] += shards[s].counts[i].load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Percentiles of merged counts. Pass `prev` to summarize only what was recorded since
+     * that merge.
+     *
+     */
+    static hist_stats_t Stats(const uint64_t *counts, const uint64_t *prev = nullptr)
+    {
+        hist_stats_t st;
+        memset(&st, 0x0, sizeof(hist_stats_t));
+        for (int i = 0; i < HIST_BUCKETS; i++)
+            st.count += counts[i] - (prev != nullptr ? prev[i] : 0);
+        if (st.count == 0)
+            return st;
+        const double q[4] = {0.5, 0.9, 0.99, 0.999};
+        double *out[4] = {&st.p50, &st.p90, &st.p99, &st.p999};
+        int j = 0;
+        uint64_t seen = 0;
+        for (int i = 0; i < HIST_BUCKETS; i++)
+        {
+            uint64_t c = counts[i] - (prev != nullptr ? prev[i] : 0);
+            if (c == 0)
+                continue;
+            seen += c;
+            while ((j < 4) && (seen >= q[j] * st.count))
+                *out[j++] = Upper(i);
+            st.max = Upper(i);
+        }
+        return st;
+    }
+};
+
+#endif // HISTOGRAM_HPP
@@ -0,0 +1,175 @@
+/**
+ * @file Instrument.hpp
+ * @brief Latency histograms of the real-time path, shared by every thread of the tracker.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * Wire layout of a stats STATUS payload, little endian, no padding:
+ *   stats_header_t, then `count` stats_wire_t, one per instrument, covering the interval since
+ *   the previous frame.
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef INSTRUMENT_HPP
+#define INSTRUMENT_HPP
+
+#include <Histogram.hpp>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#define STATS_VERSION 1
+#define STATS_PERIOD 10 // seconds between stats frames
+
+typedef enum
+{
+    INSTR_TICK_JITTER,  // |interval between timer callbacks - tick period|
+    INSTR_TRACK,        // time spent in Track()
+    INSTR_LOCK_WAIT,    // time Track() waited for the target system lock
+    INSTR_SERIAL_WRITE, // one motor command written to the port
+    INSTR_NET_SEND,     // one NetFrame sent
+    INSTR_MOTOR_RTT,    // rotator command or query until the position report answering it
+    INSTR_COUNT,
+} instr_id_t;
+
+static const char *const instr_names[INSTR_COUNT] = {"tick jitter", "Track()", "lock wait", "serial write", "net send", "motor rtt"};
+
+#pragma pack(push, 1)
+typedef struct
+{
+    uint8_t version;     // STATS_VERSION
+    uint8_t count;       // instruments that follow
+    uint8_t entry_size;  // sizeof(stats_wire_t) of the sender
+    uint8_t reserved;
+    uint32_t interval_ms; // covered by this frame
+} stats_header_t;
+
+typedef struct
+{
+    uint8_t id; // instr_id_t
+    uint8_t reserved[3];
+    uint32_t count;
+    float p50;  // microseconds
+    float p99;  // microseconds
+    float p999; // microseconds
+    float max;  // microseconds
+} stats_wire_t;
+#pragma pack(pop)
+
+/**
+ * @brief Monotonic nanoseconds, for timing the hot path.
+ *
+ */
+static inline uint64_t instr_now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+class Instruments
+{
+private:
+    Histogram hist[INSTR_COUNT];
+
+public:
+    void Record(instr_id_t id, uint64_t ns)
+    {
+        hist[id].Record(ns);
+    }
+
+    /**
+     * @brief Time since `start` (from instr_now()) into instrument `id`.
+     *
+     */
+    void Since(instr_id_t id, uint64_t start)
+    {
+        hist[id].Record(instr_now() - start);
+    }
+
+    void Merge(instr_id_t id, uint64_t *counts) const
+    {
+        hist[id].Merge(counts);
+    }
+
+    /**
+     * @brief Human readable totals since start-up.
+     *
+     */
+    void Dump(FILE *fp) const
+    {
+        uint64_t counts[HIST_BUCKETS];
+        fprintf(fp, "%-14s %12s %10s %10s %10s %10s %10s\n", "instrument", "count", "p50 us", "p90 us", "p99 us", "p99.9 us", "max us");
+        for (int i = 0; i < INSTR_COUNT; i++)
+        {
+            hist[i].Merge(counts);
+            hist_stats_t st = Histogram::Stats(counts);
+            fprintf(fp, "%-14s %12lu %10.1f %10.1f %10.1f %10.1f %10.1f\n", instr_names[i], (unsigned long)st.count, st.p50 * 1e-3, st.p90 * 1e-3, st.p99 * 1e-3, st.p999 * 1e-3, st.max * 1e-3);
+        }
+    }
+};
+
+/**
+ * @brief The process-wide instruments.
+ *
+ */
+inline Instruments &instruments()
+{
+    static Instruments instr;
+    return instr;
+}
+
+/**
+ * @brief Builds stats frames from what was recorded since the previous one.
+ *
+ */
+class StatsReporter
+{
+private:
+    uint64_t prev[INSTR_COUNT][HIST_BUCKETS] = {{0}};
+    uint64_t last = 0; // instr_now() of the previous frame
+
+public:
+    /**
+     * @brief Pack the interval since the last call into `buf`.
+     *
+     * @return int Payload size, -1 if `size` is too small.
+     */
+    int Pack(unsigned char *buf, int size)
+    {
+        int need = sizeof(stats_header_t) + INSTR_COUNT * sizeof(stats_wire_t);
+        if (size < need)
+            return -1;
+        uint64_t now = instr_now();
+        stats_header_t hdr;
+        hdr.version = STATS_VERSION;
+        hdr.count = INSTR_COUNT;
+        hdr.entry_size = sizeof(stats_wire_t);
+        hdr.reserved = 0;
+        hdr.interval_ms = last == 0 ? 0 : (now - last) / 1000000;
+        last = now;
+        memcpy(buf, &hdr, sizeof(hdr));
+        unsigned char *p = buf + sizeof(hdr);
+        uint64_t counts[HIST_BUCKETS];
+        for (int i = 0; i < INSTR_COUNT; i++, p += sizeof(stats_wire_t))
+        {
+            instruments().Merge((instr_id_t)i, counts);
+            hist_stats_t st = Histogram::Stats(counts, prev[i]);
+            memcpy(prev[i], counts, sizeof(counts));
+            stats_wire_t w;
+            memset(&w, 0x0, sizeof(w));
+            w.id = i;
+            w.count = st.count;
+            w.p50 = st.p50 * 1e-3;
+            w.p99 = st.p99 * 1e-3;
+            w.p999 = st.p999 * 1e-3;
+            w.max = st.max * 1e-3;
+            memcpy(p, &w, sizeof(w));
+        }
+        return p - buf;
+    }
+};
+
+#endif // INSTRUMENT_HPP
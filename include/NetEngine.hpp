@@ -0,0 +1,554 @@
+/**
+ * @file NetEngine.hpp
+ * @brief Event-driven client connection to the ground station server: one epoll thread owns the
+ * socket and does the receiving, sending, heartbeats and reconnects.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * Frames are still encoded and decoded by NetFrame on the NetDataClient's socket; the engine
+ * decides when. Connects are non-blocking. After a disconnect the first attempt follows in
+ * NET_BACKOFF_MIN, and every failure doubles the wait up to NET_BACKOFF_MAX. Other threads send
+ * through a bounded queue, which the engine thread is woken to flush, and are refused while
+ * the connection is down instead of writing to a dead socket.
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef NET_ENGINE_HPP
+#define NET_ENGINE_HPP
+
+#include "network.hpp"
+#include "meb_debug.h"
+#include <Instrument.hpp>
+#include <RingLog.hpp>
+#include <algorithm>
+#include <atomic>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#ifdef SERVER_IP
+#define NET_SERVER_HOST SERVER_IP // network.hpp
+#else
+#define NET_SERVER_HOST "127.0.0.1"
+#endif
+#define NET_BACKOFF_MIN 10       // ms from a disconnect to the first reconnect attempt
+#define NET_BACKOFF_MAX 5000     // ms, longest wait between attempts
+#define NET_CONNECT_TIMEOUT 2000 // ms a connect may stay in progress
+#define NET_IO_TIMEOUT 1000      // ms a frame may take to arrive or leave once started
+#define NET_TX_QUEUE 32          // frames waiting to be sent
+#define NET_MAX_EVENTS 4
+
+/**
+ * @brief Called on the engine thread for every received frame. The frame is reused for the
+ * next one.
+ *
+ */
+typedef void (*net_rx_t)(void *ctx, NetFrame *frame);
+
+typedef struct
+{
+    int connects;         // connections established
+    int disconnects;      // established connections lost
+    int failures;         // connect attempts that failed
+    int sent;             // frames sent, heartbeats excluded
+    int dropped;          // frames refused: not connected or queue full
+    int received;         // frames received
+    int heartbeats;       // POLL frames sent
+    double reconnect_ms;  // last time from losing the connection to having it back
+} net_stats_t;
+
+typedef struct
+{
+    NetType type;
+    NetVertex dest;
+    int size;
+    unsigned char payload[NETWORK_FRAME_MAX_PAYLOAD_SIZE];
+} net_tx_t;
+
+class NetEngine
+{
+private:
+    typedef enum
+    {
+        NET_DOWN,
+        NET_CONNECTING,
+        NET_UP,
+    } net_state_t;
+
+    NetDataClient *netdata = nullptr;
+    struct sockaddr_storage addr;
+    socklen_t addrlen = 0;
+    net_rx_t rx = nullptr;
+    void *ctx = nullptr;
+
+    int epfd = -1;
+    int evfd = -1; // wakes the engine: frames queued or Stop()
+    int fd = -1;
+    net_state_t state = NET_DOWN;
+    pthread_t tid;
+    std::atomic<bool> running{false};
+    NetFrame *frame = nullptr;
+
+    pthread_mutex_t lock; // queue, connected, stats
+    pthread_cond_t cond;  // connection came up
+    net_tx_t queue[NET_TX_QUEUE];
+    int head = 0, count = 0;
+    bool connected = false;
+    net_stats_t stats;
+
+    // engine thread only, instr_now() nanoseconds
+    uint64_t retry_at = 0, connect_deadline = 0, poll_due = 0, down_since = 0;
+    int backoff = NET_BACKOFF_MIN;
+
+    static uint64_t ms(int v)
+    {
+        return v * 1000000ULL;
+    }
+
+    void wake()
+    {
+        uint64_t one = 1;
+        ssize_t retval = write(evfd, &one, sizeof(one)); // fails only on a saturated counter, already awake
+        (void)retval;
+    }
+
+    void close_socket()
+    {
+        if (fd < 0)
+            return;
+        epoll_ctl(epfd, EPOLL_CTL_DEL, fd, NULL);
+        close(fd);
+        fd = -1;
+    }
+
+    /**
+     * @brief A connect attempt failed, try again after the backoff, which doubles.
+     *
+     */
+    void fail(const char *reason)
+    {
+        close_socket();
+        state = NET_DOWN;
+        uint64_t now = instr_now();
+        retry_at = now + ms(backoff);
+        backoff = std::min(backoff * 2, NET_BACKOFF_MAX);
+        pthread_mutex_lock(&lock);
+        stats.failures++;
+        pthread_mutex_unlock(&lock);
+        if (backoff == NET_BACKOFF_MAX)
+            rlogf(LOG_ERROR, RED_FG "Could not connect to the server (%s), retrying every %d ms.", reason, NET_BACKOFF_MAX);
+    }
+
+    /**
+     * @brief An established connection was lost. Queued frames are dropped, they describe the
+     * past by the time the connection is back.
+     *
+     */
+    void down(const char *reason)
+    {
+        rlogf(LOG_ERROR, RED_BG "Connection lost (%s).", reason);
+        close_socket();
+        strncpy(netdata->disconnect_reason, reason, sizeof(netdata->disconnect_reason) - 1);
+        netdata->connection_ready = false;
+        state = NET_DOWN;
+        down_since = instr_now();
+        retry_at = down_since + ms(backoff);
+        pthread_mutex_lock(&lock);
+        connected = false;
+        stats.disconnects++;
+        stats.dropped += count;
+        count = 0;
+        pthread_mutex_unlock(&lock);
+    }
+
+    void up()
+    {
+        // NetFrame reads and writes whole frames with blocking calls, bounded by the timeouts
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+        struct timeval tv = {NET_IO_TIMEOUT / 1000, (NET_IO_TIMEOUT % 1000) * 1000};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+        int on = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &on, sizeof(on));
+        struct epoll_event ev;
+        memset(&ev, 0x0, sizeof(ev));
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.fd = fd;
+        epoll_ctl(epfd, EPOLL_CTL_MOD, fd, &ev);
+
+        netdata->socket = fd;
+        netdata->connection_ready = true;
+        state = NET_UP;
+        backoff = NET_BACKOFF_MIN;
+        uint64_t now = instr_now();
+        poll_due = now; // announce ourselves right away
+        pthread_mutex_lock(&lock);
+        connected = true;
+        stats.connects++;
+        if (down_since != 0)
+            stats.reconnect_ms = (now - down_since) * 1e-6;
+        pthread_cond_broadcast(&cond);
+        pthread_mutex_unlock(&lock);
+        down_since = 0;
+        rlogf(LOG_INFO, GREEN_FG "Connected to the server.");
+    }
+
+    void start_connect()
+    {
+        if (down_since == 0)
+            down_since = instr_now();
+        fd = socket(addr.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0)
+        {
+            fail("socket");
+            return;
+        }
+        struct epoll_event ev;
+        memset(&ev, 0x0, sizeof(ev));
+        ev.events = EPOLLOUT;
+        ev.data.fd = fd;
+        epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+        if (connect(fd, (struct sockaddr *)&addr, addrlen) == 0)
+            up();
+        else if (errno == EINPROGRESS)
+        {
+            state = NET_CONNECTING;
+            connect_deadline = instr_now() + ms(NET_CONNECT_TIMEOUT);
+        }
+        else
+            fail(strerror(errno));
+    }
+
+    void finish_connect()
+    {
+        int err = 0;
+        socklen_t len = sizeof(err);
+        if ((getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) < 0) || (err != 0))
+            fail(strerror(err));
+        else
+            up();
+    }
+
+    void receive()
+    {
+        int retval = frame->recvFrame(netdata);
+        if (retval == -404)
+            down("SERVER-FORCED");
+        else if ((retval < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK)))
+            down("TIMED-OUT"); // a frame started and stalled
+        else if ((retval < 0) && ((errno == ECONNRESET) || (errno == EPIPE) || (errno == ENOTCONN)))
+            down("RESET");
+        else if (retval < 0)
+        {
+            rlogf(LOG_WARN, YELLOW_FG "Bad frame received (%d).", retval);
+        }
+        else
+        {
+            pthread_mutex_lock(&lock);
+            stats.received++;
+            pthread_mutex_unlock(&lock);
+            rx(ctx, frame);
+        }
+    }
+
+    void heartbeat()
+    {
+        NetFrame poll(NULL, 0, NetType::POLL, NetVertex::SERVER);
+        poll_due = instr_now() + netdata->polling_rate * 1000000000ULL;
+        if (poll.sendFrame(netdata) < 0)
+        {
+            down("SEND-FAILED");
+            return;
+        }
+        pthread_mutex_lock(&lock);
+        stats.heartbeats++;
+        pthread_mutex_unlock(&lock);
+    }
+
+    void flush()
+    {
+        net_tx_t tx;
+        while (state == NET_UP)
+        {
+            pthread_mutex_lock(&lock);
+            if (count == 0)
+            {
+                pthread_mutex_unlock(&lock);
+                return;
+            }
+            tx = queue[head];
+            head = (head + 1) % NET_TX_QUEUE;
+            count--;
+            pthread_mutex_unlock(&lock);
+
+            NetFrame out(tx.payload, tx.size, tx.type, tx.dest);
+            uint64_t start = instr_now();
+            int retval = out.sendFrame(netdata);
+            instruments().Since(INSTR_NET_SEND, start);
+            if (retval < 0)
+            {
+                down("SEND-FAILED");
+                return;
+            }
+            pthread_mutex_lock(&lock);
+            stats.sent++;
+            pthread_mutex_unlock(&lock);
+        }
+    }
+
+    /**
+     * @brief Milliseconds until the next thing the engine has to do without being woken.
+     *
+     */
+    int timeout(uint64_t now) const
+    {
+        uint64_t due = now + ms(1000);
+        if (state == NET_DOWN)
+            due = std::min(due, retry_at);
+        else if (state == NET_CONNECTING)
+            due = std::min(due, connect_deadline);
+        else
+            due = std::min(due, poll_due);
+        return due > now ? (due - now + 999999) / 1000000 : 0;
+    }
+
+    static void *thread(void *p)
+    {
+        NetEngine *e = (NetEngine *)p;
+        struct epoll_event events[NET_MAX_EVENTS];
+        while (e->running)
+        {
+            uint64_t now = instr_now();
+            if ((e->state == NET_DOWN) && (now >= e->retry_at))
+                e->start_connect();
+            else if ((e->state == NET_CONNECTING) && (now >= e->connect_deadline))
+                e->fail("CONNECT-TIMEOUT");
+            else if ((e->state == NET_UP) && (now >= e->poll_due))
+                e->heartbeat();
+
+            int n = epoll_wait(e->epfd, events, NET_MAX_EVENTS, e->timeout(instr_now()));
+            for (int i = 0; i < n; i++)
+            {
+                if (events[i].data.fd == e->evfd)
+                {
+                    uint64_t v;
+                    if (read(e->evfd, &v, sizeof(v)) < 0)
+                        continue;
+                    e->flush();
+                }
+                else if (events[i].data.fd != e->fd) // closed earlier in this batch
+                    continue;
+                else if (e->state == NET_CONNECTING)
+                    e->finish_connect();
+                else if (events[i].events & EPOLLIN) // also reports a closed connection
+                    e->receive();
+                else if (events[i].events & (EPOLLERR | EPOLLHUP | EPOLLRDHUP))
+                    e->down("SERVER-FORCED");
+            }
+        }
+        return NULL;
+    }
+
+public:
+    NetEngine()
+    {
+        memset(&stats, 0x0, sizeof(stats));
+        pthread_mutex_init(&lock, NULL);
+        pthread_cond_init(&cond, NULL);
+    }
+
+    ~NetEngine()
+    {
+        Stop();
+        pthread_mutex_destroy(&lock);
+        pthread_cond_destroy(&cond);
+    }
+
+    NetEngine(const NetEngine &) = delete;
+    NetEngine &operator=(const NetEngine &) = delete;
+
+    /**
+     * @brief Start connecting to `server`, "host" or "host:port" (port defaults to the
+     * NetDataClient's server port), and keep the connection up until Stop().
+     *
+     * @return int 1 on success, -1 if the server cannot be resolved, -2 if already running,
+     * -3 if the engine cannot be set up.
+     */
+    int Start(NetDataClient *netdata, const char *server, net_rx_t rx, void *ctx)
+    {
+        if (running)
+            return -2;
+        char host[256];
+        strncpy(host, server, sizeof(host) - 1);
+        host[sizeof(host) - 1] = '\0';
+        char port[16];
+        snprintf(port, sizeof(port), "%d", (int)netdata->server_port);
+        char *colon = strrchr(host, ':');
+        if ((colon != NULL) && (strchr(host, ':') == colon)) // not an IPv6 address
+        {
+            *colon = '\0';
+            snprintf(port, sizeof(port), "%s", colon + 1);
+        }
+        struct addrinfo hints, *res;
+        memset(&hints, 0x0, sizeof(hints));
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        if ((getaddrinfo(host, port, &hints, &res) != 0) || (res == NULL))
+            return -1;
+        memcpy(&addr, res->ai_addr, res->ai_addrlen);
+        addrlen = res->ai_addrlen;
+        freeaddrinfo(res);
+
+        epfd = epoll_create1(EPOLL_CLOEXEC);
+        evfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        struct epoll_event ev;
+        memset(&ev, 0x0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.fd = evfd;
+        if ((epfd < 0) || (evfd < 0) || (epoll_ctl(epfd, EPOLL_CTL_ADD, evfd, &ev) < 0))
+        {
+            Stop();
+            return -3;
+        }
+        this->netdata = netdata;
+        this->rx = rx;
+        this->ctx = ctx;
+        frame = new NetFrame();
+        netdata->connection_ready = false;
+        netdata->recv_active = true;
+        netdata->thread_status = 1;
+        state = NET_DOWN;
+        retry_at = 0;
+        backoff = NET_BACKOFF_MIN;
+        running = true;
+        if (pthread_create(&tid, NULL, thread, this) != 0)
+        {
+            running = false;
+            Stop();
+            return -3;
+        }
+        return 1;
+    }
+
+    /**
+     * @brief Close the connection and stop the engine thread.
+     *
+     */
+    void Stop()
+    {
+        if (running)
+        {
+            running = false;
+            wake();
+            pthread_join(tid, NULL);
+        }
+        close_socket();
+        if (evfd >= 0)
+            close(evfd);
+        if (epfd >= 0)
+            close(epfd);
+        evfd = epfd = -1;
+        delete frame;
+        frame = nullptr;
+        if (netdata != nullptr)
+        {
+            netdata->connection_ready = false;
+            netdata->recv_active = false;
+            netdata->thread_status = 0;
+        }
+        pthread_mutex_lock(&lock);
+        connected = false;
+        count = 0;
+        pthread_mutex_unlock(&lock);
+    }
+
+    /**
+     * @brief Queue a frame for the engine to send. Never blocks on the network.
+     *
+     * @return int 1 if queued, -1 if not connected, -2 if the queue is full, -3 if the payload
+     * is too large.
+     */
+    int Send(NetType type, const unsigned char *payload, int size, NetVertex dest = NetVertex::CLIENT)
+    {
+        if ((size < 0) || (size > NETWORK_FRAME_MAX_PAYLOAD_SIZE))
+            return -3;
+        pthread_mutex_lock(&lock);
+        int retval = 1;
+        if (!connected)
+            retval = -1;
+        else if (count == NET_TX_QUEUE)
+            retval = -2;
+        if (retval < 0)
+        {
+            stats.dropped++;
+            pthread_mutex_unlock(&lock);
+            return retval;
+        }
+        net_tx_t &tx = queue[(head + count) % NET_TX_QUEUE];
+        tx.type = type;
+        tx.dest = dest;
+        tx.size = size;
+        memcpy(tx.payload, payload, size);
+        count++;
+        pthread_mutex_unlock(&lock);
+        wake();
+        return 1;
+    }
+
+    bool IsConnected()
+    {
+        pthread_mutex_lock(&lock);
+        bool retval = connected;
+        pthread_mutex_unlock(&lock);
+        return retval;
+    }
+
+    /**
+     * @brief Wait up to `timeout_ms` for the connection to be up.
+     *
+     * @return int 1 if connected, 0 on timeout.
+     */
+    int WaitConnected(int timeout_ms)
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_sec += timeout_ms / 1000;
+        ts.tv_nsec += (timeout_ms % 1000) * 1000000L;
+        if (ts.tv_nsec >= 1000000000L)
+        {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000L;
+        }
+        pthread_mutex_lock(&lock);
+        while (!connected && running)
+            if (pthread_cond_timedwait(&cond, &lock, &ts) == ETIMEDOUT)
+                break;
+        int retval = connected ? 1 : 0;
+        pthread_mutex_unlock(&lock);
+        return retval;
+    }
+
+    net_stats_t GetStats()
+    {
+        pthread_mutex_lock(&lock);
+        net_stats_t retval = stats;
+        pthread_mutex_unlock(&lock);
+        return retval;
+    }
+};
+
+#endif // NET_ENGINE_HPP
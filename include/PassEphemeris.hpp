@@ -0,0 +1,251 @@
+/**
+ * @file PassEphemeris.hpp
+ * @brief Per-pass look angle table, interpolated instead of propagated on every tick.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * The table doubles as the range and range-rate profile of the pass, which the tracker turns
+ * into Doppler shifts for the radios.
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef PASS_EPHEMERIS_HPP
+#define PASS_EPHEMERIS_HPP
+
+#include <SGP4/CoordTopocentric.h>
+#include <SGP4/Observer.h>
+#include <SGP4/SGP4.h>
+#include <math.h>
+#include <string.h>
+#include <vector>
+
+#define EPHEM_STEP 10         // Seconds between table samples
+#define EPHEM_DERIV_STEP 0.5  // Seconds, half-width of the central difference used for rates
+#define EPHEM_MAX_PASS 1800   // Seconds, longest pass a table will cover
+
+/**
+ * @brief One table sample. Angles are in radians, azimuth is unwrapped across the pass.
+ *
+ */
+typedef struct
+{
+    double az;      // radians, continuous across 0/2pi
+    double el;      // radians
+    double range;   // km
+    double daz;     // radians/s
+    double del;     // radians/s
+    double drange;  // km/s
+    double ddrange; // km/s^2
+} ephem_sample_t;
+
+/**
+ * @brief Interpolation error against direct SGP4, angles in degrees, range in km.
+ *
+ */
+typedef struct
+{
+    double max_az;
+    double max_el;
+    double max_range;
+    double max_range_rate; // km/s
+    double sum_az2;
+    double sum_el2;
+    int count;
+} ephem_error_t;
+
+class PassEphemeris
+{
+private:
+    DateTime start;
+    double step = EPHEM_STEP;
+    double span = 0;
+    std::vector<ephem_sample_t> samples;
+
+    static double unwrap(double az, double ref)
+    {
+        return az + 2 * M_PI * round((ref - az) / (2 * M_PI));
+    }
+
+    static CoordTopocentric look(SGP4 *sgp, Observer *obs, const DateTime &dt)
+    {
+        Eci eci = sgp->FindPosition(dt);
+        return obs->GetLookAngle(eci);
+    }
+
+public:
+    /**
+     * @brief Build the table for [from, to] at `step` seconds. Costs three propagations per sample.
+     *
+     * @return int 1 on success, -1 on invalid arguments.
+     */
+    int Build(SGP4 *sgp, Observer *obs, const DateTime &from, const DateTime &to, double step = EPHEM_STEP)
+    {
+        samples.clear();
+        span = 0;
+        if ((sgp == nullptr) || (obs == nullptr) || (step <= 0) || (to <= from))
+            return -1;
+        this->start = from;
+        this->step = step;
+        double total = (to - from).TotalSeconds();
+        if (total > EPHEM_MAX_PASS)
+            total = EPHEM_MAX_PASS;
+        int num = ceil(total / step) + 1;
+        samples.reserve(num);
+        double prev_az = 0;
+        for (int i = 0; i < num; i++)
+        {
+            DateTime dt = from.AddSeconds(i * step);
+            CoordTopocentric c = look(sgp, obs, dt);
+            CoordTopocentric cm = look(sgp, obs, dt.AddSeconds(-EPHEM_DERIV_STEP));
+            CoordTopocentric cp = look(sgp, obs, dt.AddSeconds(EPHEM_DERIV_STEP));
+            ephem_sample_t s;
+            s.az = i == 0 ? c.azimuth : unwrap(c.azimuth, prev_az);
+            s.el = c.elevation;
+            s.range = c.range;
+            s.daz = (unwrap(cp.azimuth, s.az) - unwrap(cm.azimuth, s.az)) / (2 * EPHEM_DERIV_STEP);
+            s.del = (cp.elevation - cm.elevation) / (2 * EPHEM_DERIV_STEP);
+            s.drange = c.range_rate;
+            s.ddrange = (cp.range_rate - cm.range_rate) / (2 * EPHEM_DERIV_STEP);
+            prev_az = s.az;
+            samples.push_back(s);
+        }
+        span = (num - 1) * step;
+        return 1;
+    }
+
+    void Clear()
+    {
+        samples.clear();
+        span = 0;
+    }
+
+    bool IsValid() const
+    {
+        return samples.size() > 1;
+    }
+
+    DateTime Start() const
+    {
+        return start;
+    }
+
+    DateTime End() const
+    {
+        return start.AddSeconds(span);
+    }
+
+    int Size() const
+    {
+        return samples.size();
+    }
+
+    double Step() const
+    {
+        return step;
+    }
+
+    const ephem_sample_t *Samples() const
+    {
+        return samples.data();
+    }
+
+    /**
+     * @brief Restore a table saved from Start(), Step() and Samples().
+     *
+     * @return int 1 on success, -1 on invalid arguments.
+     */
+    int Load(const DateTime &start, double step, const ephem_sample_t *samples, int count)
+    {
+        Clear();
+        if ((samples == nullptr) || (count < 2) || (step <= 0))
+            return -1;
+        this->start = start;
+        this->step = step;
+        this->samples.assign(samples, samples + count);
+        span = (count - 1) * step;
+        return 1;
+    }
+
+    /**
+     * @brief Cubic Hermite interpolation of az/el/range/range rate, in the same units
+     * GetLookAngle returns. The range rate has its own polynomial, several times more accurate
+     * near closest approach than the derivative of the range one.
+     *
+     * @return int 1 on success, -1 if dt is outside the table, -2 if the table is empty.
+     */
+    int Interpolate(const DateTime &dt, CoordTopocentric &coord) const
+    {
+        if (!IsValid())
+            return -2;
+        double t = (dt - start).TotalSeconds();
+        if ((t < 0) || (t > span))
+            return -1;
+        int k = t / step;
+        if (k >= (int)samples.size() - 1)
+            k = samples.size() - 2;
+        double u = (t - k * step) / step;
+        double u2 = u * u, u3 = u2 * u;
+        double h00 = 2 * u3 - 3 * u2 + 1, h10 = u3 - 2 * u2 + u;
+        double h01 = -2 * u3 + 3 * u2, h11 = u3 - u2;
+        const ephem_sample_t &a = samples[k];
+        const ephem_sample_t &b = samples[k + 1];
+        double az = h00 * a.az + h10 * step * a.daz + h01 * b.az + h11 * step * b.daz;
+        coord.elevation = h00 * a.el + h10 * step * a.del + h01 * b.el + h11 * step * b.del;
+        coord.range = h00 * a.range + h10 * step * a.drange + h01 * b.range + h11 * step * b.drange;
+        coord.range_rate = h00 * a.drange + h10 * step * a.ddrange + h01 * b.drange + h11 * step * b.ddrange;
+        az = fmod(az, 2 * M_PI);
+        if (az < 0)
+            az += 2 * M_PI;
+        coord.azimuth = az;
+        return 1;
+    }
+
+    /**
+     * @brief Accumulate the difference between an interpolated and a directly computed look angle.
+     *
+     */
+    static void AccumulateError(const CoordTopocentric &interp, const CoordTopocentric &direct, ephem_error_t *err)
+    {
+        double daz = fabs(interp.azimuth - direct.azimuth) * 180 / M_PI;
+        if (daz > 180)
+            daz = 360 - daz;
+        double del = fabs(interp.elevation - direct.elevation) * 180 / M_PI;
+        double drange = fabs(interp.range - direct.range);
+        double drate = fabs(interp.range_rate - direct.range_rate);
+        if (daz > err->max_az)
+            err->max_az = daz;
+        if (del > err->max_el)
+            err->max_el = del;
+        if (drange > err->max_range)
+            err->max_range = drange;
+        if (drate > err->max_range_rate)
+            err->max_range_rate = drate;
+        err->sum_az2 += daz * daz;
+        err->sum_el2 += del * del;
+        err->count++;
+    }
+
+    /**
+     * @brief Sweep the whole table at `dt_step` seconds and compare against direct SGP4.
+     *
+     * @return int Number of points compared, -1 if the table is empty.
+     */
+    int Validate(SGP4 *sgp, Observer *obs, double dt_step, ephem_error_t *err) const
+    {
+        if (!IsValid() || (dt_step <= 0) || (err == nullptr))
+            return -1;
+        memset(err, 0x0, sizeof(ephem_error_t));
+        for (double t = 0; t <= span; t += dt_step)
+        {
+            DateTime dt = start.AddSeconds(t);
+            CoordTopocentric interp;
+            Interpolate(dt, interp);
+            AccumulateError(interp, look(sgp, obs, dt), err);
+        }
+        return err->count;
+    }
+};
+
+#endif // PASS_EPHEMERIS_HPP
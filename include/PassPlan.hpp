@@ -0,0 +1,396 @@
+/**
+ * @file PassPlan.hpp
+ * @brief Rotator trajectory for one pass, planned before AOS.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * The target's azimuth is continuous across north, the rotator's is not: it has to stay between
+ * its stops. The planner picks the azimuth turn (the multiple of 360 degrees added to the target
+ * azimuth) that keeps the whole pass between the stops and is closest to the dish. When no turn
+ * fits, the pass is split where a single swing through the full turn loses the least signal.
+ *
+ * Near the zenith the azimuth rate of a pass exceeds what the rotator can follow. Besides the
+ * direct trajectory, which lags behind the target until it catches up, the planner tries an
+ * offset trajectory that starts turning early and is half way through the turn at culmination,
+ * and, on rotators that can tilt past 90 degrees, the flipped trajectory: one half of the pass is
+ * flown at azimuth + 180, elevation 180 - el, so the dish tilts through the zenith instead of
+ * turning. The one with the least time outside half the beamwidth wins, then the one with the
+ * least slewing.
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef PASS_PLAN_HPP
+#define PASS_PLAN_HPP
+
+#include <PassEphemeris.hpp>
+#include <TrackingMotor.hpp>
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+#include <vector>
+
+#define PLAN_STEP 1   // seconds between trajectory points
+#define PLAN_SPLIT 10 // trajectory points between the places tried for a full-turn swing
+#define PLAN_KEYHOLE 90 // degrees/s of azimuth beyond which the direction of travel is ambiguous
+
+typedef enum
+{
+    PLAN_DIRECT, // follow the target, lag where it is too fast
+    PLAN_OFFSET, // turn early, centered on the fast part
+} plan_mode_t;
+
+/**
+ * @brief How a plan was made and what it costs. Times in seconds, angles in degrees.
+ *
+ */
+typedef struct
+{
+    int mode;         // plan_mode_t
+    bool flip;        // elevation past 90 degrees
+    int swings;       // full turns of the azimuth axis during the pass
+    double slew;      // dish moving at a rate limit, including the move to the start
+    double loss;      // target outside half the beamwidth
+    double max_error; // largest pointing error
+} plan_report_t;
+
+/**
+ * @brief What the planner needs to know about the antenna.
+ *
+ */
+typedef struct
+{
+    rotator_limits_t limits;
+    rotator_range_t range;
+    double beamwidth; // degrees, full width
+} plan_params_t;
+
+typedef struct
+{
+    double az; // degrees, rotator coordinates
+    double el;
+} plan_point_t;
+
+class PassPlan
+{
+private:
+    DateTime start;
+    std::vector<plan_point_t> points;
+    plan_report_t report;
+
+    /**
+     * @brief Azimuth turn that keeps [lo, hi] inside the stops and starts closest to `ref`.
+     *
+     * @return int 1 on success, -1 if no turn fits.
+     */
+    static int turn(double lo, double hi, double first, double ref, const rotator_range_t &range, double *offset)
+    {
+        int kmin = ceil((range.az_min - lo) / 360);
+        int kmax = floor((range.az_max - hi) / 360);
+        if (kmin > kmax)
+            return -1;
+        int best = kmin;
+        for (int k = kmin + 1; k <= kmax; k++)
+            if (fabs(first + 360 * k - ref) < fabs(first + 360 * best - ref))
+                best = k;
+        *offset = 360 * best;
+        return 1;
+    }
+
+    /**
+     * @brief Move toward `cmd` from `pos` as fast as the rotator allows for one step.
+     *
+     * @return bool Whether an axis was held back by its rate limit.
+     */
+    static bool follow(plan_point_t &pos, const plan_point_t &cmd, const rotator_limits_t &limits, double step)
+    {
+        double daz = cmd.az - pos.az, del = cmd.el - pos.el;
+        double maz = limits.az_rate * step, mel = limits.el_rate * step;
+        bool limited = (fabs(daz) > maz) || (fabs(del) > mel);
+        pos.az += copysign(std::min(fabs(daz), maz), daz);
+        pos.el += copysign(std::min(fabs(del), mel), del);
+        return limited;
+    }
+
+    /**
+     * @brief Where the dish will be when sent `cmd` point by point, starting on cmd[0].
+     *
+     */
+    static void track(const std::vector<plan_point_t> &cmd, const rotator_limits_t &limits, std::vector<plan_point_t> &out)
+    {
+        out.resize(cmd.size());
+        plan_point_t pos = cmd[0];
+        for (size_t i = 0; i < cmd.size(); i++)
+        {
+            follow(pos, cmd[i], limits, PLAN_STEP);
+            out[i] = pos;
+        }
+    }
+
+    /**
+     * @brief Feasible trajectory centered on the fast part of `cmd`: the average of the dish
+     * chasing it forward and backward in time.
+     *
+     */
+    static void center(const std::vector<plan_point_t> &cmd, const rotator_limits_t &limits, std::vector<plan_point_t> &out)
+    {
+        track(cmd, limits, out);
+        plan_point_t pos = cmd.back();
+        for (size_t i = cmd.size(); i-- > 0;)
+        {
+            follow(pos, cmd[i], limits, PLAN_STEP);
+            out[i].az = (out[i].az + pos.az) / 2;
+            out[i].el = (out[i].el + pos.el) / 2;
+        }
+    }
+
+    /**
+     * @brief Cost of flying `traj` (already feasible) against the target, from a dish at `dish`.
+     *
+     */
+    static plan_report_t evaluate(const std::vector<plan_point_t> &traj, const std::vector<plan_point_t> &target, const plan_point_t &dish, const plan_params_t &par)
+    {
+        plan_report_t rep;
+        memset(&rep, 0x0, sizeof(plan_report_t));
+        rep.slew = std::max(fabs(traj[0].az - dish.az) / par.limits.az_rate, fabs(traj[0].el - dish.el) / par.limits.el_rate);
+        for (size_t i = 0; i < traj.size(); i++)
+        {
+            if ((i > 0) && ((fabs(traj[i].az - traj[i - 1].az) >= par.limits.az_rate * PLAN_STEP * 0.99) || (fabs(traj[i].el - traj[i - 1].el) >= par.limits.el_rate * PLAN_STEP * 0.99)))
+                rep.slew += PLAN_STEP;
+            double err = rotator_distance(traj[i].az, traj[i].el, target[i].az, target[i].el);
+            if (err > par.beamwidth / 2)
+                rep.loss += PLAN_STEP;
+            rep.max_error = std::max(rep.max_error, err);
+        }
+        return rep;
+    }
+
+    static bool better(const plan_report_t &a, const plan_report_t &b)
+    {
+        if (fabs(a.loss - b.loss) > PLAN_STEP / 2.0)
+            return a.loss < b.loss;
+        return a.slew < b.slew;
+    }
+
+    /**
+     * @brief Try the direct and offset trajectories for rotator commands `cmd`, keep the best.
+     *
+     */
+    void consider(const std::vector<plan_point_t> &cmd, const std::vector<plan_point_t> &target, const plan_point_t &dish, const plan_params_t &par, bool flip, int swings)
+    {
+        std::vector<plan_point_t> traj;
+        for (int mode = PLAN_DIRECT; mode <= PLAN_OFFSET; mode++)
+        {
+            if (mode == PLAN_DIRECT)
+                track(cmd, par.limits, traj);
+            else
+                center(cmd, par.limits, traj);
+            plan_report_t rep = evaluate(traj, target, dish, par);
+            rep.mode = mode;
+            rep.flip = flip;
+            rep.swings = swings;
+            if (points.empty() || better(rep, report))
+            {
+                points = traj;
+                report = rep;
+            }
+        }
+    }
+
+    /**
+     * @brief Plan the pass in one orientation. `az` is continuous, `el` may be past 90.
+     *
+     */
+    void orient(const std::vector<double> &az, const std::vector<double> &el, const std::vector<plan_point_t> &target, const plan_point_t &dish, const plan_params_t &par, bool flip)
+    {
+        int n = az.size();
+        std::vector<plan_point_t> cmd(n);
+        for (int i = 0; i < n; i++)
+            cmd[i].el = std::min(std::max(el[i], 0.0), par.range.el_max);
+        // range of azimuth before and after every point
+        std::vector<double> pre_lo(n), pre_hi(n), post_lo(n), post_hi(n);
+        for (int i = 0; i < n; i++)
+        {
+            pre_lo[i] = i == 0 ? az[i] : std::min(pre_lo[i - 1], az[i]);
+            pre_hi[i] = i == 0 ? az[i] : std::max(pre_hi[i - 1], az[i]);
+        }
+        for (int i = n - 1; i >= 0; i--)
+        {
+            post_lo[i] = i == n - 1 ? az[i] : std::min(post_lo[i + 1], az[i]);
+            post_hi[i] = i == n - 1 ? az[i] : std::max(post_hi[i + 1], az[i]);
+        }
+        double off;
+        if (turn(pre_lo[n - 1], pre_hi[n - 1], az[0], dish.az, par.range, &off) > 0) // fits in one turn
+        {
+            for (int i = 0; i < n; i++)
+                cmd[i].az = az[i] + off;
+            consider(cmd, target, dish, par, flip, 0);
+            return;
+        }
+        // swing once, between s - 1 and s; the split has to fall between the stops on both sides,
+        // which may leave a single point, so the edges of that region are always tried
+        std::vector<char> feasible(n + 1, 0);
+        std::vector<double> off1(n, 0), off2(n, 0);
+        for (int s = 1; s < n; s++)
+            feasible[s] = (turn(pre_lo[s - 1], pre_hi[s - 1], az[0], dish.az, par.range, &off1[s]) > 0) && (turn(post_lo[s], post_hi[s], az[s], az[s - 1] + off1[s], par.range, &off2[s]) > 0);
+        for (int s = 1; s < n; s++)
+        {
+            if (!feasible[s] || ((s % PLAN_SPLIT != 0) && feasible[s - 1] && feasible[s + 1]))
+                continue;
+            for (int i = 0; i < n; i++)
+                cmd[i].az = az[i] + (i < s ? off1[s] : off2[s]);
+            consider(cmd, target, dish, par, flip, 1);
+        }
+    }
+
+public:
+    PassPlan()
+    {
+        memset(&report, 0x0, sizeof(plan_report_t));
+    }
+
+    /**
+     * @brief Plan the window [from, to] from the pass table, for a dish at `dish_az`, `dish_el`
+     * (rotator coordinates, degrees).
+     *
+     * @return int 1 on success, -1 on invalid arguments, -2 if no trajectory fits the rotator.
+     */
+    int Build(const PassEphemeris &table, const DateTime &from, const DateTime &to, double dish_az, double dish_el, const plan_params_t &par)
+    {
+        Clear();
+        if (!table.IsValid() || (to <= from))
+            return -1;
+        int n = ceil((to - from).TotalSeconds() / PLAN_STEP) + 1;
+        std::vector<plan_point_t> target(n);
+        std::vector<double> az(n), el(n);
+        for (int i = 0; i < n; i++)
+        {
+            CoordTopocentric coord;
+            if (table.Interpolate(from.AddSeconds(i * PLAN_STEP), coord) < 0)
+                return -1;
+            target[i].az = coord.azimuth * 180 / M_PI;
+            target[i].el = coord.elevation * 180 / M_PI;
+            az[i] = target[i].az;
+            if (i > 0) // continuous across north
+                az[i] += 360 * round((az[i - 1] - az[i]) / 360);
+            el[i] = target[i].el;
+        }
+        // through the keyhole the azimuth jumps by about half a turn, either way round will do
+        int key = 0;
+        for (int i = 1; i < n; i++)
+            if (fabs(az[i] - az[i - 1]) > fabs(az[key] - az[key > 0 ? key - 1 : 0]))
+                key = i;
+        bool keyhole = (key > 0) && (fabs(az[key] - az[key - 1]) > PLAN_KEYHOLE * PLAN_STEP);
+        plan_point_t dish = {dish_az, dish_el};
+        for (int way = 0; way < (keyhole ? 2 : 1); way++)
+        {
+            if (way > 0)
+                for (int i = key; i < n; i++)
+                    az[i] -= copysign(360, az[key] - az[key - 1]);
+            orient(az, el, target, dish, par, false);
+        }
+        if (par.range.el_max >= 180 - 1e-6) // over the top: tilt through the zenith at culmination
+        {
+            int top = 0;
+            for (int i = 1; i < n; i++)
+                if (el[i] > el[top])
+                    top = i;
+            for (int half = 0; half < 2; half++) // flip before or after culmination
+            {
+                for (int i = 0; i < n; i++)
+                {
+                    bool over = half == 0 ? i < top : i >= top;
+                    az[i] = target[i].az + (over ? 180 : 0);
+                    el[i] = over ? 180 - target[i].el : target[i].el;
+                    if (i > 0)
+                        az[i] += 360 * round((az[i - 1] - az[i]) / 360);
+                }
+                orient(az, el, target, dish, par, true);
+            }
+        }
+        if (points.empty())
+            return -2;
+        start = from;
+        return 1;
+    }
+
+    void Clear()
+    {
+        points.clear();
+        memset(&report, 0x0, sizeof(plan_report_t));
+    }
+
+    bool IsValid() const
+    {
+        return points.size() > 0;
+    }
+
+    DateTime Start() const
+    {
+        return start;
+    }
+
+    DateTime End() const
+    {
+        return start.AddSeconds((points.size() - 1) * PLAN_STEP);
+    }
+
+    const plan_report_t &Report() const
+    {
+        return report;
+    }
+
+    int Size() const
+    {
+        return points.size();
+    }
+
+    const plan_point_t *Points() const
+    {
+        return points.data();
+    }
+
+    /**
+     * @brief Restore a plan saved from Start(), Points() and Report().
+     *
+     * @return int 1 on success, -1 on invalid arguments.
+     */
+    int Load(const DateTime &start, const plan_point_t *points, int count, const plan_report_t &report)
+    {
+        Clear();
+        if ((points == nullptr) || (count < 1))
+            return -1;
+        this->start = start;
+        this->points.assign(points, points + count);
+        this->report = report;
+        return 1;
+    }
+
+    /**
+     * @brief Planned rotator position at `dt`, degrees, linear between trajectory points.
+     *
+     * @return int 1 on success, -1 if dt is outside the plan, -2 if there is no plan.
+     */
+    int Look(const DateTime &dt, double *az, double *el) const
+    {
+        if (!IsValid())
+            return -2;
+        double t = (dt - start).TotalSeconds() / PLAN_STEP;
+        if ((t < 0) || (t > points.size() - 1))
+            return -1;
+        size_t k = t;
+        if (k >= points.size() - 1)
+        {
+            *az = points.back().az;
+            *el = points.back().el;
+            return 1;
+        }
+        double u = t - k;
+        *az = points[k].az + u * (points[k + 1].az - points[k].az);
+        *el = points[k].el + u * (points[k + 1].el - points[k].el);
+        return 1;
+    }
+};
+
+#endif // PASS_PLAN_HPP
@@ -0,0 +1,291 @@
+/**
+ * @file PassPredictor.hpp
+ * @brief Finds AOS, TCA and LOS of upcoming passes by bracketing and root refinement.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef PASS_PREDICTOR_HPP
+#define PASS_PREDICTOR_HPP
+
+#include <BatchLook.hpp>
+#include <SGP4/CoordTopocentric.h>
+#include <SGP4/Observer.h>
+#include <SGP4/SGP4.h>
+#include <SatTrack.hpp>
+#include <math.h>
+#include <vector>
+
+#define PASS_COARSE_STEP 60  // Seconds between bracketing samples
+#define PASS_TOLERANCE 0.1   // Seconds, refinement stops below this bracket width
+#define PASS_MAX_LENGTH 1800 // Seconds, how far back to look when starting inside a pass
+
+typedef struct
+{
+    DateTime aos;
+    DateTime tca;
+    DateTime los;
+    double max_el; // radians
+    double aos_az; // radians
+    double los_az; // radians
+} pass_t;
+
+class PassPredictor
+{
+private:
+    SGP4 *sgp;
+    const SatTrack *track; // used instead of sgp when set
+    Observer obs;
+    BatchLook look;
+    double el_min;
+    std::vector<double> coarse; // elevation over the mask at each bracketing sample, track only
+
+    Eci position(const DateTime &dt)
+    {
+        return track != nullptr ? track->At(dt) : sgp->FindPosition(dt);
+    }
+
+    double elevation(const DateTime &dt)
+    {
+        return obs.GetLookAngle(position(dt)).elevation - el_min;
+    }
+
+    /**
+     * @brief Elevation over the mask at bracketing sample `k`, from the batch when it covers `k`.
+     *
+     */
+    double sample(const DateTime &dt, int k)
+    {
+        return (k >= 0) && (k < (int)coarse.size()) ? coarse[k] : elevation(dt);
+    }
+
+    /**
+     * @brief Look angles of the bracketing samples from `from` to PASS_MAX_LENGTH past the horizon,
+     * in one batch. Only on a shared track, where interpolating is cheap and the per-call
+     * GetLookAngle is most of the cost.
+     *
+     */
+    void scan(const DateTime &from, double horizon)
+    {
+        coarse.clear();
+        if (track == nullptr)
+            return;
+        int n = ceil((horizon + PASS_MAX_LENGTH) / PASS_COARSE_STEP) + 1;
+        std::vector<DateTime> times(n);
+        batch_state_t states;
+        states.x.resize(n);
+        states.y.resize(n);
+        states.z.resize(n);
+        states.vx.resize(n);
+        states.vy.resize(n);
+        states.vz.resize(n);
+        states.status.assign(n, 1);
+        for (int k = 0; k < n; k++)
+        {
+            times[k] = from.AddSeconds(k * PASS_COARSE_STEP);
+            Eci eci = track->At(times[k]);
+            states.x[k] = eci.Position().x;
+            states.y[k] = eci.Position().y;
+            states.z[k] = eci.Position().z;
+            states.vx[k] = eci.Velocity().x;
+            states.vy[k] = eci.Velocity().y;
+            states.vz[k] = eci.Velocity().z;
+        }
+        batch_look_t looks;
+        look.Compute(states, times.data(), looks);
+        coarse.resize(n);
+        for (int k = 0; k < n; k++)
+            coarse[k] = looks.el[k] - el_min;
+    }
+
+    double azimuth(const DateTime &dt)
+    {
+        return obs.GetLookAngle(position(dt)).azimuth;
+    }
+
+    /**
+     * @brief Bisect a horizon crossing. Elevation at `below` is under the mask, at `above` over it.
+     *
+     */
+    DateTime crossing(DateTime below, DateTime above)
+    {
+        while (fabs((above - below).TotalSeconds()) > PASS_TOLERANCE)
+        {
+            DateTime mid = below.AddSeconds((above - below).TotalSeconds() / 2);
+            if (elevation(mid) < 0)
+                below = mid;
+            else
+                above = mid;
+        }
+        return above;
+    }
+
+    /**
+     * @brief Golden section search for the elevation maximum in [a, b].
+     *
+     */
+    DateTime maximum(const DateTime &a, const DateTime &b, double *max_el)
+    {
+        const double r = (sqrt(5) - 1) / 2;
+        double lo = 0, hi = (b - a).TotalSeconds();
+        double x1 = hi - r * (hi - lo), x2 = lo + r * (hi - lo);
+        double f1 = elevation(a.AddSeconds(x1)), f2 = elevation(a.AddSeconds(x2));
+        while (hi - lo > PASS_TOLERANCE)
+        {
+            if (f1 < f2)
+            {
+                lo = x1;
+                x1 = x2;
+                f1 = f2;
+                x2 = lo + r * (hi - lo);
+                f2 = elevation(a.AddSeconds(x2));
+            }
+            else
+            {
+                hi = x2;
+                x2 = x1;
+                f2 = f1;
+                x1 = hi - r * (hi - lo);
+                f1 = elevation(a.AddSeconds(x1));
+            }
+        }
+        DateTime tmax = a.AddSeconds((lo + hi) / 2);
+        if (max_el != nullptr)
+            *max_el = elevation(tmax) + el_min;
+        return tmax;
+    }
+
+    int fill(const DateTime &aos, const DateTime &los, pass_t &pass)
+    {
+        pass.aos = aos;
+        pass.los = los;
+        pass.tca = maximum(aos, los, &pass.max_el);
+        pass.aos_az = azimuth(aos);
+        pass.los_az = azimuth(los);
+        return 1;
+    }
+
+public:
+    /**
+     * @brief The predictor keeps its own copy of the observer, since GetLookAngle is not reentrant.
+     *
+     */
+    PassPredictor(SGP4 *sgp, const CoordGeodetic &location, double el_min) : sgp(sgp), track(nullptr), obs(location), look(location), el_min(el_min)
+    {
+    }
+
+    /**
+     * @brief Predict from a shared track instead of propagating. The track has to cover the
+     * search: PASS_MAX_LENGTH before `from` to PASS_MAX_LENGTH after the horizon.
+     *
+     */
+    PassPredictor(const SatTrack *track, const CoordGeodetic &location, double el_min) : sgp(nullptr), track(track), obs(location), look(location), el_min(el_min)
+    {
+    }
+
+    /**
+     * @brief Find up to `max_passes` passes starting within `horizon` seconds of `from`.
+     * A pass already in progress at `from` is reported with its true AOS. A pass still in
+     * progress PASS_MAX_LENGTH after the horizon (e.g. a geostationary target) ends there, or
+     * at the end of the shared track if that comes first.
+     *
+     * @return int Number of passes found, -1 on invalid arguments.
+     */
+    int FindPasses(const DateTime &from, double horizon, int max_passes, std::vector<pass_t> &passes)
+    {
+        passes.clear();
+        if (((sgp == nullptr) && ((track == nullptr) || !track->IsValid())) || (horizon <= 0) || (max_passes <= 0))
+            return -1;
+        scan(from, horizon);
+        DateTime aos = from;
+        bool inpass = false;
+        double e0 = sample(from, 0);
+        if (e0 >= 0) // in a pass, walk back to its AOS
+        {
+            DateTime back = from;
+            for (int i = 0; (i < PASS_MAX_LENGTH) && (elevation(back) >= 0); i += PASS_COARSE_STEP)
+                back = back.AddSeconds(-PASS_COARSE_STEP);
+            aos = elevation(back) < 0 ? crossing(back, from) : back;
+            inpass = true;
+        }
+        DateTime prev = from, prev2 = from;
+        double prev_e = e0, prev2_e = e0;
+        DateTime end = from.AddSeconds(horizon);
+        DateTime limit = end.AddSeconds(PASS_MAX_LENGTH); // never sets, stop scanning here
+        if ((track != nullptr) && (track->End() < limit)) // At() only extrapolates past the track
+            limit = track->End();
+        int k = 1;
+        for (DateTime t = from.AddSeconds(PASS_COARSE_STEP); (int)passes.size() < max_passes; t = t.AddSeconds(PASS_COARSE_STEP), k++)
+        {
+            if (t > limit)
+            {
+                if (inpass)
+                {
+                    pass_t pass;
+                    fill(aos, prev, pass);
+                    passes.push_back(pass);
+                }
+                break;
+            }
+            double e = sample(t, k);
+            if (inpass && (e >= 0) && (t >= limit))
+            {
+                pass_t pass;
+                fill(aos, t, pass);
+                passes.push_back(pass);
+                break;
+            }
+            if (!inpass && (e >= 0)) // rose between samples
+            {
+                if (t > end)
+                    break;
+                aos = crossing(prev, t);
+                inpass = true;
+            }
+            else if (inpass && (e < 0)) // set between samples
+            {
+                pass_t pass;
+                fill(aos, crossing(t, prev), pass);
+                passes.push_back(pass);
+                inpass = false;
+            }
+            else if (!inpass && (prev_e > prev2_e) && (prev_e > e)) // local maximum below the mask, may hide a short pass
+            {
+                double max_el;
+                DateTime tmax = maximum(prev2, t, &max_el);
+                if ((max_el >= el_min) && (tmax <= end))
+                {
+                    pass_t pass;
+                    fill(crossing(prev2, tmax), crossing(t, tmax), pass);
+                    passes.push_back(pass);
+                }
+            }
+            else if (!inpass && (t > end))
+                break;
+            prev2 = prev;
+            prev2_e = prev_e;
+            prev = t;
+            prev_e = e;
+        }
+        return passes.size();
+    }
+
+    /**
+     * @brief Convenience wrapper for the first pass within `horizon` seconds.
+     *
+     * @return int 1 if a pass was found, 0 if none, -1 on invalid arguments.
+     */
+    int NextPass(const DateTime &from, double horizon, pass_t &pass)
+    {
+        std::vector<pass_t> passes;
+        int retval = FindPasses(from, horizon, 1, passes);
+        if (retval > 0)
+            pass = passes[0];
+        return retval;
+    }
+};
+
+#endif // PASS_PREDICTOR_HPP
@@ -0,0 +1,327 @@
+/**
+ * @file PassScheduler.hpp
+ * @brief Builds a conflict-free timeline of passes for several targets sharing one dish.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef PASS_SCHEDULER_HPP
+#define PASS_SCHEDULER_HPP
+
+#include <PassPredictor.hpp>
+#include <TrackingMotor.hpp>
+#include <SGP4/CoordTopocentric.h>
+#include <algorithm>
+#include <math.h>
+#include <vector>
+
+#define SCHED_MIN_PASS 60     // Seconds, shortest window worth scheduling
+#define SCHED_PASS_MATCH 1.0  // Seconds, passes whose AOS and LOS agree this well are the same pass
+
+/**
+ * @brief Look angle of `target` at `dt`, supplied by the owner of the propagators.
+ *
+ * @return int 1 on success, negative on error.
+ */
+typedef int (*sched_look_t)(void *ctx, int target, const DateTime &dt, CoordTopocentric *coord);
+
+/**
+ * @brief A window of the timeline given to one target. Angles are in radians.
+ *
+ */
+typedef struct
+{
+    int target;   // NORAD ID
+    int priority; // higher wins
+    pass_t pass;  // the full pass, start/end may be trimmed inside it
+    DateTime start;
+    DateTime end;
+    double start_az;
+    double start_el;
+    double end_az;
+    double end_el;
+} sched_entry_t;
+
+class PassScheduler
+{
+private:
+    typedef struct
+    {
+        int target;
+        int priority;
+        pass_t pass;
+    } candidate_t;
+
+    std::vector<candidate_t> candidates; // every predicted pass of every target
+    std::vector<sched_entry_t> timeline; // sorted by start, non-overlapping
+    rotator_limits_t limits;
+    sched_look_t look;
+    void *ctx;
+
+    static bool samePass(const pass_t &a, const pass_t &b)
+    {
+        return (fabs((a.aos - b.aos).TotalSeconds()) < SCHED_PASS_MATCH) && (fabs((a.los - b.los).TotalSeconds()) < SCHED_PASS_MATCH);
+    }
+
+    static void grow(DateTime &from, DateTime &to, bool &empty, const DateTime &a, const DateTime &b)
+    {
+        if (empty || (a < from))
+            from = a;
+        if (empty || (b > to))
+            to = b;
+        empty = false;
+    }
+
+    /**
+     * @brief Try to place a candidate in the largest gap left inside its pass.
+     *
+     * @return int 1 if placed, 0 if no gap is long enough.
+     */
+    int place(const candidate_t &c)
+    {
+        CoordTopocentric at_aos, at_los;
+        if ((look(ctx, c.target, c.pass.aos, &at_aos) < 0) || (look(ctx, c.target, c.pass.los, &at_los) < 0))
+            return 0;
+        size_t next = 0; // first entry starting after the pass AOS
+        while ((next < timeline.size()) && (timeline[next].start < c.pass.aos))
+            next++;
+        double best = 0;
+        sched_entry_t entry;
+        // gaps are [prev.end, next.start] for consecutive entries around the pass
+        for (size_t i = next > 0 ? next - 1 : 0; i <= timeline.size(); i++)
+        {
+            const sched_entry_t *prev = (i > 0) ? &timeline[i - 1] : nullptr;
+            const sched_entry_t *after = (i < timeline.size()) ? &timeline[i] : nullptr;
+            if ((prev != nullptr) && (prev->end > c.pass.los))
+                break;
+            if ((after != nullptr) && (after->end < c.pass.aos))
+                continue;
+            DateTime start = c.pass.aos, end = c.pass.los;
+            if ((prev != nullptr) && (prev->end > start))
+                start = prev->end;
+            if ((after != nullptr) && (after->start < end))
+                end = after->start;
+            if (end <= start)
+                continue;
+            CoordTopocentric s = at_aos, e = at_los;
+            if ((start != c.pass.aos) && (look(ctx, c.target, start, &s) < 0))
+                continue;
+            if ((end != c.pass.los) && (look(ctx, c.target, end, &e) < 0))
+                continue;
+            // leave room to slew in from the previous target and out to the next one
+            if (prev != nullptr)
+                start = std::max(start, prev->end.AddSeconds(SlewTime(prev->end_az, prev->end_el, s.azimuth, s.elevation)));
+            if (after != nullptr)
+                end = std::min(end, after->start.AddSeconds(-SlewTime(e.azimuth, e.elevation, after->start_az, after->start_el)));
+            double len = (end - start).TotalSeconds();
+            if ((len >= SCHED_MIN_PASS) && (len > best))
+            {
+                if ((look(ctx, c.target, start, &s) < 0) || (look(ctx, c.target, end, &e) < 0))
+                    continue;
+                best = len;
+                entry.target = c.target;
+                entry.priority = c.priority;
+                entry.pass = c.pass;
+                entry.start = start;
+                entry.end = end;
+                entry.start_az = s.azimuth;
+                entry.start_el = s.elevation;
+                entry.end_az = e.azimuth;
+                entry.end_el = e.elevation;
+            }
+        }
+        if (best <= 0)
+            return 0;
+        size_t i = 0;
+        while ((i < timeline.size()) && (timeline[i].start < entry.start))
+            i++;
+        timeline.insert(timeline.begin() + i, entry);
+        return 1;
+    }
+
+    /**
+     * @brief Whether the timeline still has a window for this pass.
+     *
+     */
+    bool scheduled(const candidate_t &c) const
+    {
+        for (size_t i = 0; i < timeline.size(); i++)
+            if ((timeline[i].target == c.target) && samePass(timeline[i].pass, c.pass))
+                return true;
+        return false;
+    }
+
+    /**
+     * @brief Clear the timeline inside [from, to] and refill it from the candidates, highest
+     * priority first. Entries outside the window are left untouched.
+     *
+     * @return int Number of entries placed.
+     */
+    int reschedule(DateTime from, DateTime to)
+    {
+        // anything overlapping the window goes and widens it, until nothing else overlaps
+        bool empty = false, grown = true;
+        while (grown)
+        {
+            grown = false;
+            for (size_t i = 0; i < timeline.size(); i++)
+            {
+                const sched_entry_t &e = timeline[i];
+                if ((e.end >= from) && (e.start <= to) && ((e.pass.aos < from) || (e.pass.los > to)))
+                {
+                    grow(from, to, empty, e.pass.aos, e.pass.los);
+                    grown = true;
+                }
+            }
+        }
+        for (size_t i = 0; i < timeline.size();)
+        {
+            if ((timeline[i].end >= from) && (timeline[i].start <= to))
+                timeline.erase(timeline.begin() + i);
+            else
+                i++;
+        }
+        // a surviving window may still cover part of a pass inside the window
+        std::vector<const candidate_t *> todo;
+        for (size_t i = 0; i < candidates.size(); i++)
+            if ((candidates[i].pass.los >= from) && (candidates[i].pass.aos <= to) && !scheduled(candidates[i]))
+                todo.push_back(&candidates[i]);
+        std::sort(todo.begin(), todo.end(), [](const candidate_t *a, const candidate_t *b) {
+            if (a->priority != b->priority)
+                return a->priority > b->priority;
+            if (a->pass.max_el != b->pass.max_el)
+                return a->pass.max_el > b->pass.max_el;
+            return a->pass.aos < b->pass.aos;
+        });
+        int placed = 0;
+        for (size_t i = 0; i < todo.size(); i++)
+            placed += place(*todo[i]);
+        return placed;
+    }
+
+public:
+    PassScheduler(sched_look_t look, void *ctx) : look(look), ctx(ctx)
+    {
+        limits.az_rate = ROTATOR_AZ_RATE;
+        limits.el_rate = ROTATOR_EL_RATE;
+        limits.settle = ROTATOR_SETTLE;
+    }
+
+    void SetLimits(const rotator_limits_t &limits)
+    {
+        this->limits = limits;
+    }
+
+    /**
+     * @brief Seconds needed to move the dish between two pointings given in radians.
+     *
+     */
+    double SlewTime(double az0, double el0, double az1, double el1) const
+    {
+        double taz = fabs(az1 - az0) * 180 / M_PI / limits.az_rate;
+        double tel = fabs(el1 - el0) * 180 / M_PI / limits.el_rate;
+        return std::max(taz, tel) + limits.settle;
+    }
+
+    /**
+     * @brief Replace the predicted passes of one target. Only the part of the timeline covered
+     * by passes that actually changed is rescheduled.
+     *
+     * @return int Number of entries placed while rescheduling.
+     */
+    int SetPasses(int target, int priority, const std::vector<pass_t> &passes)
+    {
+        DateTime from, to;
+        bool empty = true;
+        bool prio_changed = false;
+        std::vector<candidate_t> kept;
+        kept.reserve(candidates.size() + passes.size());
+        for (size_t i = 0; i < candidates.size(); i++)
+        {
+            const candidate_t &c = candidates[i];
+            if (c.target != target)
+            {
+                kept.push_back(c);
+                continue;
+            }
+            if (c.priority != priority)
+                prio_changed = true;
+            bool found = false;
+            for (size_t j = 0; (j < passes.size()) && !found; j++)
+                found = samePass(c.pass, passes[j]);
+            if (!found || prio_changed) // gone or reweighted
+                grow(from, to, empty, c.pass.aos, c.pass.los);
+        }
+        for (size_t j = 0; j < passes.size(); j++)
+        {
+            bool found = false;
+            for (size_t i = 0; (i < candidates.size()) && !found; i++)
+                found = (candidates[i].target == target) && samePass(candidates[i].pass, passes[j]);
+            if (!found || prio_changed) // new
+                grow(from, to, empty, passes[j].aos, passes[j].los);
+            candidate_t c = {target, priority, passes[j]};
+            kept.push_back(c);
+        }
+        candidates.swap(kept);
+        if (empty)
+            return 0;
+        return reschedule(from, to);
+    }
+
+    /**
+     * @brief Forget a target and give its windows to the others.
+     *
+     * @return int Number of entries placed while rescheduling.
+     */
+    int RemoveTarget(int target)
+    {
+        std::vector<pass_t> none;
+        return SetPasses(target, 0, none);
+    }
+
+    /**
+     * @brief Drop everything that ended before `now`.
+     *
+     */
+    void Prune(const DateTime &now)
+    {
+        size_t n = 0;
+        while ((n < timeline.size()) && (timeline[n].end < now))
+            n++;
+        timeline.erase(timeline.begin(), timeline.begin() + n);
+        for (size_t i = 0; i < candidates.size();)
+        {
+            if (candidates[i].pass.los < now)
+            {
+                candidates[i] = candidates.back();
+                candidates.pop_back();
+            }
+            else
+                i++;
+        }
+    }
+
+    /**
+     * @brief Every pass of `target` the scheduler knows, in no particular order.
+     *
+     * @return int Number of passes.
+     */
+    int GetPasses(int target, std::vector<pass_t> &out) const
+    {
+        out.clear();
+        for (size_t i = 0; i < candidates.size(); i++)
+            if (candidates[i].target == target)
+                out.push_back(candidates[i].pass);
+        return out.size();
+    }
+
+    const std::vector<sched_entry_t> &Timeline() const
+    {
+        return timeline;
+    }
+};
+
+#endif // PASS_SCHEDULER_HPP
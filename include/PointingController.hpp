@@ -0,0 +1,215 @@
+/**
+ * @file PointingController.hpp
+ * @brief Decides when and where to move the rotator so the target stays inside the beam.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * The controller keeps a model of the dish: it starts from where it was when the last setpoint
+ * went out, and after the command latency moves toward the setpoint at the rotator's slew rates.
+ * A new setpoint is sent only when the target would otherwise leave half the beamwidth before
+ * the next chance to command. The setpoint leads the target: it is where the target will be
+ * when the dish arrives, plus the time the target takes to cross half the beam. The error then
+ * sweeps from -beam/2 to +beam/2 around the setpoint instead of only trailing it.
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef POINTING_CONTROLLER_HPP
+#define POINTING_CONTROLLER_HPP
+
+#include <TrackingMotor.hpp>
+#include <SGP4/DateTime.h>
+#include <algorithm>
+#include <math.h>
+
+#define POINT_BEAMWIDTH 2.0 // degrees, full beamwidth of the antenna
+#define POINT_LATENCY 0.15  // seconds from SetAz/SetEl until the rotator starts moving
+#define POINT_MAX_LEAD 30   // seconds, longest the setpoint may lead the target
+
+/**
+ * @brief Target position in rotator coordinates, degrees, at `dt`.
+ *
+ * @return int 1 on success, negative on error.
+ */
+typedef int (*point_look_t)(void *ctx, const DateTime &dt, double *az, double *el);
+
+class PointingController
+{
+private:
+    rotator_limits_t limits;
+    rotator_range_t range;
+    double beamwidth;   // degrees
+    double latency;     // seconds
+    double period;      // seconds between Update() calls
+    bool commanded;     // a setpoint is known
+    DateTime cmd_time;
+    double cmd_az, cmd_el;     // degrees
+    double start_az, start_el; // dish position when the setpoint went out
+
+    double slew(double az0, double el0, double az1, double el1) const
+    {
+        return std::max(fabs(az1 - az0) / limits.az_rate, fabs(el1 - el0) / limits.el_rate);
+    }
+
+public:
+    PointingController()
+    {
+        limits.az_rate = ROTATOR_AZ_RATE;
+        limits.el_rate = ROTATOR_EL_RATE;
+        limits.settle = ROTATOR_SETTLE;
+        range.az_min = ROTATOR_AZ_MIN;
+        range.az_max = ROTATOR_AZ_MAX;
+        range.el_max = ROTATOR_EL_MAX;
+        beamwidth = POINT_BEAMWIDTH;
+        latency = POINT_LATENCY;
+        period = 1;
+        commanded = false;
+        start_az = cmd_az = 0; // parked
+        start_el = cmd_el = 90;
+    }
+
+    void SetLimits(const rotator_limits_t &limits)
+    {
+        this->limits = limits;
+    }
+
+    void SetRange(const rotator_range_t &range)
+    {
+        this->range = range;
+    }
+
+    /**
+     * @brief Full beamwidth in degrees, command latency in seconds.
+     *
+     */
+    void SetBeam(double beamwidth, double latency)
+    {
+        this->beamwidth = beamwidth;
+        this->latency = latency;
+    }
+
+    /**
+     * @brief Seconds between Update() calls.
+     *
+     */
+    void SetPeriod(double period)
+    {
+        this->period = period;
+    }
+
+    /**
+     * @brief Forget the dish position, e.g. after the motor was reopened.
+     *
+     */
+    void Reset()
+    {
+        commanded = false;
+    }
+
+    /**
+     * @brief Estimated dish position at `dt`.
+     *
+     */
+    void Dish(const DateTime &dt, double *az, double *el) const
+    {
+        double s = (dt - cmd_time).TotalSeconds() - latency;
+        if (!commanded || (s <= 0))
+        {
+            *az = start_az;
+            *el = start_el;
+            return;
+        }
+        double daz = cmd_az - start_az, del = cmd_el - start_el;
+        *az = start_az + copysign(std::min(fabs(daz), limits.az_rate * s), daz);
+        *el = start_el + copysign(std::min(fabs(del), limits.el_rate * s), del);
+    }
+
+    /**
+     * @brief Record a setpoint sent outside the controller (pre-positioning, parking).
+     *
+     */
+    void Commanded(const DateTime &dt, double az, double el)
+    {
+        if (commanded)
+            Dish(dt, &start_az, &start_el);
+        else
+        {
+            start_az = az;
+            start_el = el;
+        }
+        cmd_time = dt;
+        cmd_az = az;
+        cmd_el = el;
+        commanded = true;
+    }
+
+    /**
+     * @brief Correct the dish model with a position reported by the rotator at `dt`. Reports
+     * older than the last setpoint are ignored.
+     *
+     */
+    void Measured(const DateTime &dt, double az, double el)
+    {
+        if (!commanded || (dt < cmd_time))
+            return;
+        start_az = az;
+        start_el = el;
+        cmd_time = dt.AddSeconds(-latency); // already under way
+    }
+
+    /**
+     * @brief Pointing error the current setpoint will have at `dt`, in degrees.
+     *
+     */
+    double Error(const DateTime &dt, point_look_t look, void *ctx) const
+    {
+        double az, el;
+        if (!commanded || (look(ctx, dt, &az, &el) < 0))
+            return 360;
+        return rotator_distance(cmd_az, cmd_el, az, el);
+    }
+
+    /**
+     * @brief Decide whether to command the rotator at `now`.
+     *
+     * @return int 1 with a new setpoint in `az`, `el` (degrees, whole degrees as the rotator takes
+     * them), 0 if the current setpoint is good until the next update, negative if the target
+     * cannot be looked up.
+     */
+    int Update(const DateTime &now, point_look_t look, void *ctx, double *az, double *el)
+    {
+        // the earliest a setpoint sent on the next update takes effect
+        if (commanded && (Error(now.AddSeconds(latency + period), look, ctx) <= beamwidth / 2))
+            return 0;
+        double daz, del, taz, tel;
+        if (commanded)
+            Dish(now, &daz, &del);
+        else if (look(ctx, now, &daz, &del) < 0)
+            return -1;
+        // where the target is when the dish gets there
+        DateTime arrive = now.AddSeconds(latency);
+        for (int i = 0; i < 3; i++)
+        {
+            if (look(ctx, arrive, &taz, &tel) < 0)
+                return -1;
+            arrive = now.AddSeconds(latency + slew(daz, del, taz, tel));
+        }
+        if (look(ctx, arrive, &taz, &tel) < 0)
+            return -1;
+        // lead by the time the target needs to cross half the beam
+        double naz, nel;
+        if (look(ctx, arrive.AddSeconds(1), &naz, &nel) < 0)
+            return -1;
+        double rate = rotator_distance(taz, tel, naz, nel); // degrees/s
+        double lead = rate > 0 ? std::min(beamwidth / 2 / rate, (double)POINT_MAX_LEAD) : 0;
+        if ((lead > 0) && (look(ctx, arrive.AddSeconds(lead), &taz, &tel) < 0))
+            return -1;
+        *az = std::min(std::max(round(taz), range.az_min), range.az_max);
+        *el = std::min(std::max(round(tel), 0.0), range.el_max);
+        Commanded(now, *az, *el);
+        return 1;
+    }
+};
+
+#endif // POINTING_CONTROLLER_HPP
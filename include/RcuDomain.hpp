@@ -0,0 +1,167 @@
+/**
+ * @file RcuDomain.hpp
+ * @brief Epoch-based deferred reclamation for objects read outside the lock that guards them.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * A reader registers once for a slot. It brackets each use of shared pointers with Enter() and
+ * Exit(), which are a load and a store each and never wait. A writer unpublishes an object,
+ * then hands it to Retire(). The object is freed once every reader that could have seen it has
+ * left its read section.
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef RCU_DOMAIN_HPP
+#define RCU_DOMAIN_HPP
+
+#include <atomic>
+#include <pthread.h>
+#include <stdint.h>
+#include <vector>
+
+#define RCU_MAX_READERS 16
+
+typedef void (*rcu_free_t)(void *);
+
+class RcuDomain
+{
+private:
+    typedef struct
+    {
+        void *ptr;
+        rcu_free_t free_fn;
+        uint64_t epoch; // retired at this epoch
+    } retired_t;
+
+    std::atomic<uint64_t> epoch;
+    std::atomic<uint64_t> readers[RCU_MAX_READERS]; // epoch at Enter(), 0 outside a read section
+    std::atomic<bool> claimed[RCU_MAX_READERS];
+    std::vector<retired_t> retired;
+    pthread_mutex_t retired_lock;
+
+public:
+    RcuDomain() : epoch(1)
+    {
+        for (int i = 0; i < RCU_MAX_READERS; i++)
+        {
+            readers[i].store(0);
+            claimed[i].store(false);
+        }
+        pthread_mutex_init(&retired_lock, NULL);
+    }
+
+    RcuDomain(const RcuDomain &) = delete;
+    RcuDomain &operator=(const RcuDomain &) = delete;
+
+    /**
+     * @brief Free everything still retired. No reader may be active.
+     *
+     */
+    ~RcuDomain()
+    {
+        for (size_t i = 0; i < retired.size(); i++)
+            retired[i].free_fn(retired[i].ptr);
+        pthread_mutex_destroy(&retired_lock);
+    }
+
+    /**
+     * @brief Claim a reader slot for the calling thread.
+     *
+     * @return int Slot index, -1 if all RCU_MAX_READERS slots are taken.
+     */
+    int Register()
+    {
+        for (int i = 0; i < RCU_MAX_READERS; i++)
+        {
+            bool expected = false;
+            if (claimed[i].compare_exchange_strong(expected, true))
+                return i;
+        }
+        return -1;
+    }
+
+    void Unregister(int slot)
+    {
+        readers[slot].store(0);
+        claimed[slot].store(false);
+    }
+
+    /**
+     * @brief Start a read section. Pointers loaded after this stay valid until Exit().
+     *
+     */
+    void Enter(int slot)
+    {
+        readers[slot].store(epoch.load());
+    }
+
+    void Exit(int slot)
+    {
+        readers[slot].store(0, std::memory_order_release);
+    }
+
+    /**
+     * @brief Free `ptr` with `free_fn` once no reader can still hold it. The caller must already
+     * have unpublished `ptr`.
+     *
+     */
+    void Retire(void *ptr, rcu_free_t free_fn)
+    {
+        if (ptr == nullptr)
+            return;
+        retired_t r = {ptr, free_fn, epoch.fetch_add(1)};
+        pthread_mutex_lock(&retired_lock);
+        retired.push_back(r);
+        pthread_mutex_unlock(&retired_lock);
+        Reclaim();
+    }
+
+    /**
+     * @brief Free whatever no reader can reach any more.
+     *
+     * @return int Number of objects freed.
+     */
+    int Reclaim()
+    {
+        uint64_t oldest = UINT64_MAX; // oldest epoch a reader entered at
+        for (int i = 0; i < RCU_MAX_READERS; i++)
+        {
+            uint64_t e = readers[i].load();
+            if ((e != 0) && (e < oldest))
+                oldest = e;
+        }
+        std::vector<retired_t> done;
+        pthread_mutex_lock(&retired_lock);
+        for (size_t i = 0; i < retired.size();)
+        {
+            if (retired[i].epoch < oldest) // every active reader entered after it was unpublished
+            {
+                done.push_back(retired[i]);
+                retired[i] = retired.back();
+                retired.pop_back();
+            }
+            else
+                i++;
+        }
+        pthread_mutex_unlock(&retired_lock);
+        for (size_t i = 0; i < done.size(); i++)
+            done[i].free_fn(done[i].ptr);
+        return done.size();
+    }
+
+    /**
+     * @brief Objects retired but not yet freed.
+     *
+     */
+    size_t Pending()
+    {
+        pthread_mutex_lock(&retired_lock);
+        size_t n = retired.size();
+        pthread_mutex_unlock(&retired_lock);
+        return n;
+    }
+};
+
+#endif // RCU_DOMAIN_HPP
@@ -0,0 +1,454 @@
+/**
+ * @file RingLog.hpp
+ * @brief Deferred logging for the real-time path: call sites store binary records in per-thread
+ * lock-free rings, a background thread formats and writes them.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * A call site costs a clock read and a copy of its arguments into a fixed-size record, no
+ * formatting, no locks and no system calls. Records carry a pointer to the static site (level,
+ * file, line, function, printf format), so the format string is never copied. String arguments
+ * are copied into the record, up to RINGLOG_TEXT bytes per record in total.
+ *
+ * Levels below RINGLOG_LEVEL are compiled out. Building with TARGET_SYS_DEBUG lowers the
+ * default to LOG_DEBUG. Until RingLog::Start() is called, or after Stop(), records are formatted
+ * and written on the calling thread, like dbprintlf. A full ring drops the record and counts it.
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef RING_LOG_HPP
+#define RING_LOG_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <type_traits>
+#include <unistd.h>
+#include <vector>
+
+#define LOG_DEBUG 0
+#define LOG_INFO 1
+#define LOG_WARN 2
+#define LOG_ERROR 3
+
+#ifndef RINGLOG_LEVEL
+#ifdef TARGET_SYS_DEBUG
+#define RINGLOG_LEVEL LOG_DEBUG
+#else
+#define RINGLOG_LEVEL LOG_INFO
+#endif
+#endif
+
+#define RINGLOG_ARGS 8       // most arguments of one record
+#define RINGLOG_TEXT 160     // bytes of string arguments one record holds, two TLE lines
+#define RINGLOG_RING 1024    // records per thread, a power of two
+#define RINGLOG_THREADS 32   // threads logging at the same time
+#define RINGLOG_FLUSH 50     // ms between drains
+#define RINGLOG_LINE 512     // longest formatted line
+
+/**
+ * @brief Log `format` at `level` from the real-time path. Same format and arguments as
+ * dbprintlf, which the compiler checks; the arguments are only evaluated if the level is
+ * compiled in.
+ *
+ */
+#define rlogf(level, format, ...)                                                              \
+    do                                                                                          \
+    {                                                                                           \
+        if ((level) >= RINGLOG_LEVEL)                                                           \
+        {                                                                                       \
+            static const log_site_t rlog_site = {(level), __FILE__, __LINE__, __func__, format}; \
+            (void)sizeof(printf(format, ##__VA_ARGS__));                                        \
+            ringlog().Write(&rlog_site, ##__VA_ARGS__);                                         \
+        }                                                                                       \
+    } while (0)
+
+typedef struct
+{
+    int level;
+    const char *file;
+    int line;
+    const char *func;
+    const char *format;
+} log_site_t;
+
+typedef union
+{
+    int64_t i;
+    uint64_t u;
+    double f;
+    uint32_t s; // offset into log_record_t::text
+    const void *p;
+} log_arg_t;
+
+typedef struct
+{
+    uint64_t ns;              // CLOCK_REALTIME
+    const log_site_t *site;
+    uint8_t nargs;
+    uint8_t text_len;
+    char types[RINGLOG_ARGS]; // 'i', 'u', 'f', 's', 'p'
+    log_arg_t args[RINGLOG_ARGS];
+    char text[RINGLOG_TEXT];
+} log_record_t;
+
+/**
+ * @brief Single producer (the owning thread), single consumer (the writer thread).
+ *
+ */
+class LogRing
+{
+private:
+    std::atomic<uint32_t> head{0};
+    std::atomic<uint32_t> tail{0};
+    log_record_t rec[RINGLOG_RING];
+
+public:
+    std::atomic<bool> in_use{false};
+
+    log_record_t *Claim()
+    {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) >= RINGLOG_RING)
+            return nullptr;
+        return &rec[h & (RINGLOG_RING - 1)];
+    }
+
+    void Publish()
+    {
+        head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    void Drain(std::vector<log_record_t> &out)
+    {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        uint32_t h = head.load(std::memory_order_acquire);
+        for (; t != h; t++)
+            out.push_back(rec[t & (RINGLOG_RING - 1)]);
+        tail.store(t, std::memory_order_release);
+    }
+};
+
+class RingLog
+{
+private:
+    std::atomic<LogRing *> rings[RINGLOG_THREADS];
+    std::atomic<bool> running{false};
+    std::atomic<uint64_t> dropped{0};
+    pthread_t tid;
+    FILE *out = stderr;
+
+    struct holder_t
+    {
+        LogRing *ring = nullptr;
+        ~holder_t()
+        {
+            if (ring != nullptr) // thread exits, whatever it logged is still drained
+                ring->in_use.store(false, std::memory_order_release);
+        }
+    };
+
+    LogRing *ring()
+    {
+        static thread_local holder_t holder;
+        if (holder.ring != nullptr)
+            return holder.ring;
+        for (int i = 0; i < RINGLOG_THREADS; i++)
+        {
+            LogRing *r = rings[i].load(std::memory_order_acquire);
+            bool expected = false;
+            if ((r != nullptr) && r->in_use.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+                return holder.ring = r;
+            if (r == nullptr)
+            {
+                LogRing *fresh = new LogRing();
+                fresh->in_use = true;
+                if (rings[i].compare_exchange_strong(r, fresh, std::memory_order_acq_rel))
+                    return holder.ring = fresh;
+                delete fresh;
+                i--; // another thread installed one here, try to claim it
+            }
+        }
+        return nullptr;
+    }
+
+    static uint64_t realtime_ns()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    }
+
+    static void put(log_record_t *r, const char *s)
+    {
+        r->types[r->nargs] = 's';
+        int avail = RINGLOG_TEXT - r->text_len;
+        if ((s == nullptr) || (avail <= 0)) // text is full, point at its last terminator
+        {
+            r->args[r->nargs++].s = avail <= 0 ? RINGLOG_TEXT - 1 : RINGLOG_TEXT;
+            return;
+        }
+        int n = strnlen(s, avail - 1);
+        r->args[r->nargs++].s = r->text_len;
+        memcpy(r->text + r->text_len, s, n);
+        r->text_len += n;
+        r->text[r->text_len++] = '\0';
+    }
+
+    static void put(log_record_t *r, char *s)
+    {
+        put(r, (const char *)s);
+    }
+
+    static void put(log_record_t *r, double v)
+    {
+        r->types[r->nargs] = 'f';
+        r->args[r->nargs++].f = v;
+    }
+
+    template <typename T>
+    static typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type put(log_record_t *r, T v)
+    {
+        if (std::is_signed<T>::value || std::is_enum<T>::value)
+        {
+            r->types[r->nargs] = 'i';
+            r->args[r->nargs++].i = (int64_t)v;
+        }
+        else
+        {
+            r->types[r->nargs] = 'u';
+            r->args[r->nargs++].u = (uint64_t)v;
+        }
+    }
+
+    template <typename T>
+    static typename std::enable_if<std::is_floating_point<T>::value>::type put(log_record_t *r, T v)
+    {
+        put(r, (double)v);
+    }
+
+    template <typename T>
+    static void put(log_record_t *r, const T *p)
+    {
+        r->types[r->nargs] = 'p';
+        r->args[r->nargs++].p = p;
+    }
+
+    static void encode(log_record_t *r) {}
+
+    template <typename T, typename... A>
+    static void encode(log_record_t *r, T v, A... rest)
+    {
+        put(r, v);
+        encode(r, rest...);
+    }
+
+    /**
+     * @brief One conversion of the site's format with a stored argument, converted to what the
+     * conversion expects.
+     *
+     */
+    static int convert(char *buf, size_t size, const char *spec, char conv, const log_record_t &r, int idx)
+    {
+        char fmt[32];
+        if (idx >= r.nargs)
+            return snprintf(buf, size, "?");
+        char type = r.types[idx];
+        const log_arg_t &a = r.args[idx];
+        long long iv = type == 'f' ? (long long)a.f : type == 'u' ? (long long)a.u : a.i;
+        double fv = type == 'f' ? a.f : type == 'u' ? (double)a.u : (double)a.i;
+        switch (conv)
+        {
+        case 'd':
+        case 'i':
+            snprintf(fmt, sizeof(fmt), "%sll%c", spec, conv);
+            return snprintf(buf, size, fmt, iv);
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X':
+            snprintf(fmt, sizeof(fmt), "%sll%c", spec, conv);
+            return snprintf(buf, size, fmt, (unsigned long long)iv);
+        case 'c':
+            snprintf(fmt, sizeof(fmt), "%sc", spec);
+            return snprintf(buf, size, fmt, (int)iv);
+        case 's':
+            snprintf(fmt, sizeof(fmt), "%ss", spec);
+            return snprintf(buf, size, fmt, type != 's' ? "(?)" : a.s < RINGLOG_TEXT ? r.text + a.s : "(null)");
+        case 'p':
+            snprintf(fmt, sizeof(fmt), "%sp", spec);
+            return snprintf(buf, size, fmt, a.p);
+        default: // floating point
+            snprintf(fmt, sizeof(fmt), "%s%c", spec, conv);
+            return snprintf(buf, size, fmt, fv);
+        }
+    }
+
+    static void *thread(void *p)
+    {
+        RingLog *log = (RingLog *)p;
+        std::vector<log_record_t> batch;
+        batch.reserve(RINGLOG_RING);
+        while (log->running.load(std::memory_order_acquire))
+        {
+            usleep(RINGLOG_FLUSH * 1000);
+            log->drain(batch);
+        }
+        log->drain(batch);
+        return NULL;
+    }
+
+    void drain(std::vector<log_record_t> &batch)
+    {
+        batch.clear();
+        for (int i = 0; i < RINGLOG_THREADS; i++)
+        {
+            LogRing *r = rings[i].load(std::memory_order_acquire);
+            if (r != nullptr)
+                r->Drain(batch);
+        }
+        if (batch.empty())
+            return;
+        std::stable_sort(batch.begin(), batch.end(), [](const log_record_t &a, const log_record_t &b) { return a.ns < b.ns; });
+        char line[RINGLOG_LINE];
+        for (const log_record_t &r : batch)
+        {
+            Format(r, line, sizeof(line));
+            fputs(line, out);
+        }
+        fflush(out);
+    }
+
+public:
+    RingLog()
+    {
+        for (int i = 0; i < RINGLOG_THREADS; i++)
+            rings[i] = nullptr;
+    }
+
+    /**
+     * @brief Start the writer thread. Records go to `fp` every RINGLOG_FLUSH ms.
+     *
+     * @return int 1 on success, -1 if already running or the thread cannot be created.
+     */
+    int Start(FILE *fp = stderr)
+    {
+        if (running)
+            return -1;
+        out = fp;
+        running = true;
+        if (pthread_create(&tid, NULL, thread, this) != 0)
+        {
+            running = false;
+            return -1;
+        }
+        return 1;
+    }
+
+    /**
+     * @brief Write out what is still queued and stop the writer thread.
+     *
+     */
+    void Stop()
+    {
+        if (!running)
+            return;
+        running = false;
+        pthread_join(tid, NULL);
+    }
+
+    template <typename... A>
+    void Write(const log_site_t *site, A... args)
+    {
+        static_assert(sizeof...(A) <= RINGLOG_ARGS, "too many arguments for one log record");
+        if (!running.load(std::memory_order_acquire))
+        {
+            log_record_t r;
+            r.ns = realtime_ns();
+            r.site = site;
+            r.nargs = r.text_len = 0;
+            encode(&r, args...);
+            char line[RINGLOG_LINE];
+            Format(r, line, sizeof(line));
+            fputs(line, out);
+            fflush(out);
+            return;
+        }
+        LogRing *ring = this->ring();
+        log_record_t *r = ring == nullptr ? nullptr : ring->Claim();
+        if (r == nullptr)
+        {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        r->ns = realtime_ns();
+        r->site = site;
+        r->nargs = r->text_len = 0;
+        encode(r, args...);
+        ring->Publish();
+    }
+
+    /**
+     * @brief Format a record the way dbprintlf prints, with the time it was logged in front.
+     *
+     */
+    static void Format(const log_record_t &r, char *buf, size_t size)
+    {
+        static const char end[] = "\x1b[0m\n";
+        size_t limit = size - sizeof(end); // always room for the end of the line
+        time_t sec = r.ns / 1000000000ULL;
+        struct tm tm;
+        gmtime_r(&sec, &tm);
+        int w = snprintf(buf, limit, "%02d:%02d:%02d.%06d [%s:%d | %s] ", tm.tm_hour, tm.tm_min, tm.tm_sec, (int)(r.ns % 1000000000ULL / 1000), r.site->file, r.site->line, r.site->func);
+        size_t n = std::min((size_t)std::max(w, 0), limit - 1);
+        int idx = 0;
+        for (const char *f = r.site->format; (*f != '\0') && (n < limit - 1); f++)
+        {
+            if (*f != '%')
+            {
+                buf[n++] = *f;
+                continue;
+            }
+            if (*(++f) == '%')
+            {
+                buf[n++] = '%';
+                continue;
+            }
+            char spec[16] = "%";
+            size_t len = 1;
+            while ((*f != '\0') && strchr("-+ #0123456789.", *f) && (len < sizeof(spec) - 1))
+                spec[len++] = *f++;
+            while ((*f != '\0') && strchr("hlLqjzt", *f)) // the stored argument decides the width
+                f++;
+            if (*f == '\0')
+                break;
+            spec[len] = '\0';
+            w = convert(buf + n, limit - n, spec, *f, r, idx++);
+            n = std::min(n + std::max(w, 0), limit - 1);
+        }
+        memcpy(buf + n, end, sizeof(end));
+    }
+
+    uint64_t Dropped() const
+    {
+        return dropped.load(std::memory_order_relaxed);
+    }
+};
+
+/**
+ * @brief The process-wide logger.
+ *
+ */
+inline RingLog &ringlog()
+{
+    static RingLog log;
+    return log;
+}
+
+#endif // RING_LOG_HPP
@@ -0,0 +1,124 @@
+/**
+ * @file RotatorProtocol.hpp
+ * @brief Serial dialects spoken by rotator controllers: command formatting and position reports.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * MOTOR_PROTO_PAPB, the original controller:
+ *   "PB <az>\r", "PA <el>\r"       set azimuth, elevation; both lines go out in one write
+ *   no position reports
+ * MOTOR_PROTO_GS232, Yaesu GS-232B and compatibles:
+ *   "W<aaa> <eee>\r"               set azimuth and elevation
+ *   "C2\r"                         query, answered by "AZ=<aaa> EL=<eee>\r\n" (GS-232A controllers
+ *                                  answer "+0<aaa>+0<eee>", also accepted)
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef ROTATOR_PROTOCOL_HPP
+#define ROTATOR_PROTOCOL_HPP
+
+#include <stdio.h>
+#include <string.h>
+
+#define MOTOR_AXIS_AZ 0x1
+#define MOTOR_AXIS_EL 0x2
+#define ROTATOR_LINE_MAX 64
+
+typedef enum
+{
+    MOTOR_PROTO_PAPB,
+    MOTOR_PROTO_GS232,
+} motor_proto_t;
+
+class RotatorProtocol
+{
+private:
+    int proto;
+    char line[ROTATOR_LINE_MAX]; // partial report
+    int len;
+
+public:
+    RotatorProtocol(int proto = MOTOR_PROTO_PAPB) : proto(proto), len(0) {}
+
+    int Type() const
+    {
+        return proto;
+    }
+
+    /**
+     * @brief Whether the controller reports its position.
+     *
+     */
+    bool HasFeedback() const
+    {
+        return proto == MOTOR_PROTO_GS232;
+    }
+
+    /**
+     * @brief Format a setpoint for the axes in `mask`, followed by a position query when the
+     * controller answers one, so the reply times the whole command.
+     *
+     * @return int Bytes written to `buf`, -1 if it does not fit.
+     */
+    int Command(char *buf, int size, int mask, int az, int el) const
+    {
+        int sz = 0;
+        if (proto == MOTOR_PROTO_GS232) // no single axis command, always both
+            sz = snprintf(buf, size, "W%03d %03d\rC2\r", az, el);
+        else
+        {
+            if (mask & MOTOR_AXIS_AZ)
+                sz += snprintf(buf + sz, size - sz, "PB %d\r", az);
+            if ((sz < size) && (mask & MOTOR_AXIS_EL))
+                sz += snprintf(buf + sz, size - sz, "PA %d\r", el);
+        }
+        return sz < size ? sz : -1;
+    }
+
+    /**
+     * @brief Format a position query.
+     *
+     * @return int Bytes written to `buf`, 0 if the controller has no query.
+     */
+    int Query(char *buf, int size) const
+    {
+        if (!HasFeedback() || (size < 4))
+            return 0;
+        memcpy(buf, "C2\r", 3);
+        return 3;
+    }
+
+    /**
+     * @brief Feed received bytes, one at a time.
+     *
+     * @return int 1 when a complete position report was read into `az`, `el`, 0 otherwise.
+     */
+    int Parse(char c, int *az, int *el)
+    {
+        if ((c != '\r') && (c != '\n'))
+        {
+            if (len < ROTATOR_LINE_MAX - 1)
+                line[len++] = c;
+            return 0;
+        }
+        line[len] = '\0';
+        int n = len;
+        len = 0;
+        if (n == 0)
+            return 0;
+        if (sscanf(line, "AZ=%d EL=%d", az, el) == 2)
+            return 1;
+        if (sscanf(line, "+%d+%d", az, el) == 2)
+            return 1;
+        return 0;
+    }
+
+    void Reset()
+    {
+        len = 0;
+    }
+};
+
+#endif // ROTATOR_PROTOCOL_HPP
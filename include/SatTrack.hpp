@@ -0,0 +1,116 @@
+/**
+ * @file SatTrack.hpp
+ * @brief One satellite's ECI positions over a span, propagated once and shared by every station
+ * that looks at it.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * Samples are STATION_TRACK_STEP apart. In between, position and velocity come from cubic
+ * Hermite interpolation of the neighbouring positions and velocities, which stays within a few
+ * meters of SGP4 for near-earth orbits at a 60 second step. Since look angles depend on the
+ * station only through its own position, every station can use the same samples.
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef SAT_TRACK_HPP
+#define SAT_TRACK_HPP
+
+#include <SGP4/DateTime.h>
+#include <SGP4/Eci.h>
+#include <SGP4/SGP4.h>
+#include <SGP4/Vector.h>
+#include <math.h>
+#include <exception>
+#include <vector>
+
+#define STATION_TRACK_STEP 60 // seconds between shared samples
+
+class SatTrack
+{
+private:
+    DateTime start;
+    double step = STATION_TRACK_STEP; // seconds
+    std::vector<Vector> pos;          // km
+    std::vector<Vector> vel;          // km/s
+
+public:
+    /**
+     * @brief Propagate [from, to] every `step` seconds.
+     *
+     * @return int Number of samples, -1 if the satellite cannot be propagated over the span.
+     */
+    int Build(const SGP4 &sgp, const DateTime &from, const DateTime &to, double step = STATION_TRACK_STEP)
+    {
+        pos.clear();
+        vel.clear();
+        this->step = step;
+        start = from;
+        int n = ceil((to - from).TotalSeconds() / step) + 1;
+        if (n < 2)
+            return -1;
+        pos.reserve(n);
+        vel.reserve(n);
+        try
+        {
+            for (int i = 0; i < n; i++)
+            {
+                Eci eci = sgp.FindPosition(from.AddSeconds(i * step));
+                pos.push_back(eci.Position());
+                vel.push_back(eci.Velocity());
+            }
+        }
+        catch (std::exception &e) // decayed inside the span
+        {
+            pos.clear();
+            vel.clear();
+            return -1;
+        }
+        return n;
+    }
+
+    bool IsValid() const
+    {
+        return pos.size() >= 2;
+    }
+
+    DateTime Start() const
+    {
+        return start;
+    }
+
+    DateTime End() const
+    {
+        return start.AddSeconds((pos.size() - 1) * step);
+    }
+
+    /**
+     * @brief Interpolated state at `dt`. Outside [Start(), End()] the nearest interval is
+     * extrapolated, which is only good for a fraction of a step.
+     *
+     */
+    Eci At(const DateTime &dt) const
+    {
+        double t = (dt - start).TotalSeconds() / step;
+        int i = floor(t);
+        if (i < 0)
+            i = 0;
+        else if (i > (int)pos.size() - 2)
+            i = pos.size() - 2;
+        double s = t - i, s2 = s * s, s3 = s2 * s;
+        // Hermite basis and its derivative
+        double h00 = 2 * s3 - 3 * s2 + 1, h10 = s3 - 2 * s2 + s, h01 = -2 * s3 + 3 * s2, h11 = s3 - s2;
+        double d00 = 6 * s2 - 6 * s, d10 = 3 * s2 - 4 * s + 1, d01 = -6 * s2 + 6 * s, d11 = 3 * s2 - 2 * s;
+        const Vector &p0 = pos[i], &p1 = pos[i + 1], &v0 = vel[i], &v1 = vel[i + 1];
+        Vector p(h00 * p0.x + h10 * step * v0.x + h01 * p1.x + h11 * step * v1.x,
+                 h00 * p0.y + h10 * step * v0.y + h01 * p1.y + h11 * step * v1.y,
+                 h00 * p0.z + h10 * step * v0.z + h01 * p1.z + h11 * step * v1.z);
+        Vector v((d00 * p0.x + d01 * p1.x) / step + d10 * v0.x + d11 * v1.x,
+                 (d00 * p0.y + d01 * p1.y) / step + d10 * v0.y + d11 * v1.y,
+                 (d00 * p0.z + d01 * p1.z) / step + d10 * v0.z + d11 * v1.z);
+        return Eci(dt, p, v);
+    }
+};
+
+#endif // SAT_TRACK_HPP
@@ -0,0 +1,448 @@
+/**
+ * @file ScheduleStore.hpp
+ * @brief The planner's work on disk: targets, their passes, the upcoming windows and the pass
+ * tables and rotator plans of the first ones, so a restarted tracker resumes at once.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * Everything is keyed by the station the passes were computed for (header) and by the epoch
+ * of each target's elements; passes of a target are only reused with the same elements.
+ * Binary layout, native byte order:
+ *   sched_store_header_t
+ *   sched_store_target_t[targets]
+ *   sched_store_pass_t[passes]      each target's passes, in order of the targets
+ *   sched_store_entry_t[entries]    upcoming windows, in order
+ *   ephem_sample_t[samples]         pass tables of the entries that have one
+ *   plan_point_t[points]            rotator plans of the entries that have one
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef SCHEDULE_STORE_HPP
+#define SCHEDULE_STORE_HPP
+
+#include <PassEphemeris.hpp>
+#include <PassPlan.hpp>
+#include <PassPredictor.hpp>
+#include <PassScheduler.hpp>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#define SCHED_STORE_MAGIC 0x48435354 // "TSCH"
+#define SCHED_STORE_VERSION 1
+#define SCHED_STORE_LINE 70          // 69 characters and the terminator
+#define SCHED_STORE_MATCH_ANGLE 1e-6 // degrees, same station
+#define SCHED_STORE_MATCH_ALT 1e-3   // km
+
+typedef struct
+{
+    uint32_t magic;   // SCHED_STORE_MAGIC
+    uint32_t version; // SCHED_STORE_VERSION
+    uint32_t targets;
+    uint32_t passes;
+    uint32_t entries;
+    uint32_t samples;
+    uint32_t points;
+    uint32_t reserved;
+    double lat;    // degrees, station the passes were computed for
+    double lon;    // degrees
+    double alt;    // km
+    int64_t saved; // DateTime ticks
+} sched_store_header_t;
+
+typedef struct
+{
+    int32_t id;
+    int32_t priority;
+    int64_t epoch;     // DateTime ticks of the elements the passes came from
+    int64_t predicted; // DateTime ticks, passes are known up to here
+    uint32_t pass;     // first pass
+    uint32_t count;    // passes
+    char line1[SCHED_STORE_LINE];
+    char line2[SCHED_STORE_LINE];
+} sched_store_target_t;
+
+typedef struct
+{
+    int64_t aos; // DateTime ticks
+    int64_t tca;
+    int64_t los;
+    double max_el; // radians
+    double aos_az; // radians
+    double los_az; // radians
+} sched_store_pass_t;
+
+typedef struct
+{
+    int32_t target;
+    int32_t priority;
+    sched_store_pass_t pass;
+    int64_t start; // DateTime ticks
+    int64_t end;
+    double start_az; // radians
+    double start_el;
+    double end_az;
+    double end_el;
+    int64_t table_start; // DateTime ticks
+    double table_step;   // seconds
+    uint32_t sample;     // first table sample
+    uint32_t samples;    // 0 without a table
+    int64_t plan_start;  // DateTime ticks
+    uint32_t point;      // first plan point
+    uint32_t points;     // 0 without a plan
+    plan_report_t report;
+} sched_store_entry_t;
+
+class ScheduleStore
+{
+private:
+    // owned storage, filled by the Add functions
+    sched_store_header_t header;
+    std::vector<sched_store_target_t> targets;
+    std::vector<sched_store_pass_t> passes;
+    std::vector<sched_store_entry_t> entries;
+    std::vector<ephem_sample_t> samples;
+    std::vector<plan_point_t> points;
+    // what the accessors read: the owned vectors or the mapped file
+    const sched_store_header_t *hdr = &header;
+    const sched_store_target_t *tgt = nullptr;
+    const sched_store_pass_t *pas = nullptr;
+    const sched_store_entry_t *ent = nullptr;
+    const ephem_sample_t *smp = nullptr;
+    const plan_point_t *pts = nullptr;
+    void *map = nullptr;
+    size_t map_size = 0;
+
+    static sched_store_pass_t pack(const pass_t &p)
+    {
+        sched_store_pass_t s = {p.aos.Ticks(), p.tca.Ticks(), p.los.Ticks(), p.max_el, p.aos_az, p.los_az};
+        return s;
+    }
+
+    static pass_t unpack(const sched_store_pass_t &s)
+    {
+        pass_t p;
+        p.aos = DateTime(s.aos);
+        p.tca = DateTime(s.tca);
+        p.los = DateTime(s.los);
+        p.max_el = s.max_el;
+        p.aos_az = s.aos_az;
+        p.los_az = s.los_az;
+        return p;
+    }
+
+    void owned()
+    {
+        hdr = &header;
+        header.targets = targets.size();
+        header.passes = passes.size();
+        header.entries = entries.size();
+        header.samples = samples.size();
+        header.points = points.size();
+        tgt = targets.data();
+        pas = passes.data();
+        ent = entries.data();
+        smp = samples.data();
+        pts = points.data();
+    }
+
+    void close_map()
+    {
+        if (map != nullptr)
+            munmap(map, map_size);
+        map = nullptr;
+        map_size = 0;
+    }
+
+public:
+    ScheduleStore()
+    {
+        Clear();
+    }
+
+    ~ScheduleStore()
+    {
+        close_map();
+    }
+
+    ScheduleStore(const ScheduleStore &) = delete;
+    ScheduleStore &operator=(const ScheduleStore &) = delete;
+
+    /**
+     * @brief Start an empty store for a station, degrees and km, saved at `saved`.
+     *
+     */
+    void Clear(double lat = 0, double lon = 0, double alt = 0, const DateTime &saved = DateTime())
+    {
+        close_map();
+        targets.clear();
+        passes.clear();
+        entries.clear();
+        samples.clear();
+        points.clear();
+        memset(&header, 0x0, sizeof(header));
+        header.magic = SCHED_STORE_MAGIC;
+        header.version = SCHED_STORE_VERSION;
+        header.lat = lat;
+        header.lon = lon;
+        header.alt = alt;
+        header.saved = saved.Ticks();
+        owned();
+    }
+
+    /**
+     * @brief Add a target with the passes predicted from the elements `line1`, `line2`.
+     *
+     * @return int Index of the target, -1 on missing lines.
+     */
+    int AddTarget(int id, int priority, const char *line1, const char *line2, const DateTime &epoch, const DateTime &predicted, const std::vector<pass_t> &found)
+    {
+        if ((line1 == NULL) || (line2 == NULL))
+            return -1;
+        sched_store_target_t t;
+        memset(&t, 0x0, sizeof(t));
+        t.id = id;
+        t.priority = priority;
+        t.epoch = epoch.Ticks();
+        t.predicted = predicted.Ticks();
+        t.pass = passes.size();
+        t.count = found.size();
+        snprintf(t.line1, sizeof(t.line1), "%s", line1);
+        snprintf(t.line2, sizeof(t.line2), "%s", line2);
+        for (size_t i = 0; i < found.size(); i++)
+            passes.push_back(pack(found[i]));
+        targets.push_back(t);
+        owned();
+        return targets.size() - 1;
+    }
+
+    /**
+     * @brief Append an upcoming window, with its pass table and rotator plan if they are given
+     * and valid.
+     *
+     * @return int Index of the entry.
+     */
+    int AddEntry(const sched_entry_t &e, const PassEphemeris *table = nullptr, const PassPlan *plan = nullptr)
+    {
+        sched_store_entry_t s;
+        memset(&s, 0x0, sizeof(s));
+        s.target = e.target;
+        s.priority = e.priority;
+        s.pass = pack(e.pass);
+        s.start = e.start.Ticks();
+        s.end = e.end.Ticks();
+        s.start_az = e.start_az;
+        s.start_el = e.start_el;
+        s.end_az = e.end_az;
+        s.end_el = e.end_el;
+        if ((table != nullptr) && table->IsValid())
+        {
+            s.table_start = table->Start().Ticks();
+            s.table_step = table->Step();
+            s.sample = samples.size();
+            s.samples = table->Size();
+            samples.insert(samples.end(), table->Samples(), table->Samples() + table->Size());
+        }
+        if ((plan != nullptr) && plan->IsValid())
+        {
+            s.plan_start = plan->Start().Ticks();
+            s.point = points.size();
+            s.points = plan->Size();
+            s.report = plan->Report();
+            points.insert(points.end(), plan->Points(), plan->Points() + plan->Size());
+        }
+        entries.push_back(s);
+        owned();
+        return entries.size() - 1;
+    }
+
+    /**
+     * @brief Map a store written by Save(). The accessors read the file directly.
+     *
+     * @return int Number of entries, -1 if the file cannot be read, -2 if it is not a store of
+     * this version or is inconsistent.
+     */
+    int Open(const char *path)
+    {
+        Clear();
+        int fd = open(path, O_RDONLY);
+        if (fd < 0)
+            return -1;
+        struct stat sb;
+        if ((fstat(fd, &sb) < 0) || ((size_t)sb.st_size < sizeof(sched_store_header_t)))
+        {
+            close(fd);
+            return -1;
+        }
+        void *p = mmap(NULL, sb.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (p == MAP_FAILED)
+            return -1;
+        const sched_store_header_t *h = (const sched_store_header_t *)p;
+        size_t need = sizeof(sched_store_header_t) + (size_t)h->targets * sizeof(sched_store_target_t) + (size_t)h->passes * sizeof(sched_store_pass_t) + (size_t)h->entries * sizeof(sched_store_entry_t) + (size_t)h->samples * sizeof(ephem_sample_t) + (size_t)h->points * sizeof(plan_point_t);
+        if ((h->magic != SCHED_STORE_MAGIC) || (h->version != SCHED_STORE_VERSION) || ((size_t)sb.st_size != need))
+        {
+            munmap(p, sb.st_size);
+            return -2;
+        }
+        const char *c = (const char *)p + sizeof(sched_store_header_t);
+        const sched_store_target_t *t = (const sched_store_target_t *)c;
+        c += h->targets * sizeof(sched_store_target_t);
+        const sched_store_pass_t *ps = (const sched_store_pass_t *)c;
+        c += h->passes * sizeof(sched_store_pass_t);
+        const sched_store_entry_t *e = (const sched_store_entry_t *)c;
+        c += h->entries * sizeof(sched_store_entry_t);
+        const ephem_sample_t *sm = (const ephem_sample_t *)c;
+        c += h->samples * sizeof(ephem_sample_t);
+        const plan_point_t *pt = (const plan_point_t *)c;
+        bool ok = true;
+        for (uint32_t i = 0; ok && (i < h->targets); i++) // ranges stay inside the file
+            ok = ((uint64_t)t[i].pass + t[i].count <= h->passes) && (memchr(t[i].line1, '\0', SCHED_STORE_LINE) != NULL) && (memchr(t[i].line2, '\0', SCHED_STORE_LINE) != NULL);
+        for (uint32_t i = 0; ok && (i < h->entries); i++)
+            ok = ((uint64_t)e[i].sample + e[i].samples <= h->samples) && ((uint64_t)e[i].point + e[i].points <= h->points);
+        if (!ok)
+        {
+            munmap(p, sb.st_size);
+            return -2;
+        }
+        map = p;
+        map_size = sb.st_size;
+        hdr = h;
+        tgt = t;
+        pas = ps;
+        ent = e;
+        smp = sm;
+        pts = pt;
+        return h->entries;
+    }
+
+    /**
+     * @brief Write the store to `path`, replacing it atomically so a crash never leaves half a
+     * file behind.
+     *
+     * @return int 1 on success, -1 on error.
+     */
+    int Save(const char *path) const
+    {
+        char tmp[4096];
+        if (snprintf(tmp, sizeof(tmp), "%s.tmp", path) >= (int)sizeof(tmp))
+            return -1;
+        FILE *fp = fopen(tmp, "wb");
+        if (fp == NULL)
+            return -1;
+        bool ok = fwrite(hdr, sizeof(sched_store_header_t), 1, fp) == 1;
+        ok = ok && (fwrite(tgt, sizeof(sched_store_target_t), hdr->targets, fp) == hdr->targets);
+        ok = ok && (fwrite(pas, sizeof(sched_store_pass_t), hdr->passes, fp) == hdr->passes);
+        ok = ok && (fwrite(ent, sizeof(sched_store_entry_t), hdr->entries, fp) == hdr->entries);
+        ok = ok && (fwrite(smp, sizeof(ephem_sample_t), hdr->samples, fp) == hdr->samples);
+        ok = ok && (fwrite(pts, sizeof(plan_point_t), hdr->points, fp) == hdr->points);
+        ok = (fclose(fp) == 0) && ok;
+        if (!ok || (rename(tmp, path) < 0))
+        {
+            unlink(tmp);
+            return -1;
+        }
+        return 1;
+    }
+
+    /**
+     * @brief Whether the passes were computed for the station at `lat`, `lon` (degrees), `alt`
+     * (km).
+     *
+     */
+    bool Matches(double lat, double lon, double alt) const
+    {
+        return (fabs(hdr->lat - lat) < SCHED_STORE_MATCH_ANGLE) && (fabs(hdr->lon - lon) < SCHED_STORE_MATCH_ANGLE) && (fabs(hdr->alt - alt) < SCHED_STORE_MATCH_ALT);
+    }
+
+    DateTime Saved() const
+    {
+        return DateTime(hdr->saved);
+    }
+
+    int Targets() const
+    {
+        return hdr->targets;
+    }
+
+    const sched_store_target_t *Target(int i) const
+    {
+        return &tgt[i];
+    }
+
+    /**
+     * @brief Passes of target `i`.
+     *
+     * @return int Number of passes.
+     */
+    int Passes(int i, std::vector<pass_t> &out) const
+    {
+        out.clear();
+        for (uint32_t k = 0; k < tgt[i].count; k++)
+            out.push_back(unpack(pas[tgt[i].pass + k]));
+        return out.size();
+    }
+
+    int Entries() const
+    {
+        return hdr->entries;
+    }
+
+    sched_entry_t Entry(int i) const
+    {
+        const sched_store_entry_t &s = ent[i];
+        sched_entry_t e;
+        e.target = s.target;
+        e.priority = s.priority;
+        e.pass = unpack(s.pass);
+        e.start = DateTime(s.start);
+        e.end = DateTime(s.end);
+        e.start_az = s.start_az;
+        e.start_el = s.start_el;
+        e.end_az = s.end_az;
+        e.end_el = s.end_el;
+        return e;
+    }
+
+    /**
+     * @brief Pass table of entry `i`.
+     *
+     * @return int 1 on success, -1 if the entry was saved without one.
+     */
+    int Table(int i, PassEphemeris &table) const
+    {
+        const sched_store_entry_t &s = ent[i];
+        if (s.samples == 0)
+        {
+            table.Clear();
+            return -1;
+        }
+        return table.Load(DateTime(s.table_start), s.table_step, smp + s.sample, s.samples);
+    }
+
+    /**
+     * @brief Rotator plan of entry `i`.
+     *
+     * @return int 1 on success, -1 if the entry was saved without one.
+     */
+    int Plan(int i, PassPlan &plan) const
+    {
+        const sched_store_entry_t &s = ent[i];
+        if (s.points == 0)
+        {
+            plan.Clear();
+            return -1;
+        }
+        return plan.Load(DateTime(s.plan_start), pts + s.point, s.points, s.report);
+    }
+};
+
+#endif // SCHEDULE_STORE_HPP
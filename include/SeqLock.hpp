@@ -0,0 +1,81 @@
+/**
+ * @file SeqLock.hpp
+ * @brief Single-writer sequence lock for publishing small structs to any number of readers.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * The writer never waits. Readers take no lock and leave the writer alone. A read is retried
+ * only if a store lands in the middle of it. The payload is kept in relaxed atomic words so the
+ * overlapping copy stays well defined.
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef SEQ_LOCK_HPP
+#define SEQ_LOCK_HPP
+
+#include <atomic>
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+
+template <typename T>
+class SeqLock
+{
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock payload must be trivially copyable");
+
+private:
+    static const size_t WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+    std::atomic<uint32_t> seq;
+    std::atomic<uint64_t> data[WORDS];
+
+public:
+    SeqLock() : seq(0)
+    {
+        for (size_t i = 0; i < WORDS; i++)
+            data[i].store(0, std::memory_order_relaxed);
+    }
+
+    SeqLock(const SeqLock &) = delete;
+    SeqLock &operator=(const SeqLock &) = delete;
+
+    /**
+     * @brief Publish a new value. Only one thread may store.
+     *
+     */
+    void Store(const T &val)
+    {
+        uint64_t buf[WORDS] = {0};
+        memcpy(buf, &val, sizeof(T));
+        uint32_t s = seq.load(std::memory_order_relaxed);
+        seq.store(s + 1, std::memory_order_relaxed); // odd: store in progress
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < WORDS; i++)
+            data[i].store(buf[i], std::memory_order_relaxed);
+        seq.store(s + 2, std::memory_order_release);
+    }
+
+    /**
+     * @brief Copy out the latest value.
+     *
+     * @return uint32_t Number of stores so far, 0 if nothing was published yet.
+     */
+    uint32_t Load(T &val) const
+    {
+        uint64_t buf[WORDS];
+        uint32_t s0, s1;
+        do
+        {
+            s0 = seq.load(std::memory_order_acquire);
+            for (size_t i = 0; i < WORDS; i++)
+                buf[i] = data[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            s1 = seq.load(std::memory_order_relaxed);
+        } while ((s0 & 1) || (s0 != s1));
+        memcpy(&val, buf, sizeof(T));
+        return s0 / 2;
+    }
+};
+
+#endif // SEQ_LOCK_HPP
@@ -0,0 +1,195 @@
+/**
+ * @file SessionLog.hpp
+ * @brief Records the inputs of a tracking session so it can be replayed against a virtual clock.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * One event per line, prefixed by its time in DateTime ticks:
+ *   <ticks> START <lat> <lon> <alt>        observer, degrees and km
+ *   <ticks> TLE <priority>                 followed by the two element lines
+ *   <ticks> REMOVE <id>
+ *   <ticks> PRIORITY <id> <priority>
+ *   <ticks> OBS <lat> <lon> <alt>
+ *   <ticks> END
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef SESSION_LOG_HPP
+#define SESSION_LOG_HPP
+
+#include <SGP4/DateTime.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#define SESSION_LINE_MAX 256
+
+typedef enum
+{
+    SESSION_START,
+    SESSION_TLE,
+    SESSION_REMOVE,
+    SESSION_PRIORITY,
+    SESSION_OBS,
+    SESSION_END,
+} session_event_type_t;
+
+typedef struct
+{
+    int type;         // session_event_type_t
+    int64_t ticks;    // DateTime ticks
+    char TLE1[70];
+    char TLE2[70];
+    int target;       // NORAD ID
+    int priority;
+    double lat;       // degrees
+    double lon;       // degrees
+    double alt;       // km
+} session_event_t;
+
+class SessionLog
+{
+private:
+    FILE *fp = NULL;
+    pthread_mutex_t lock;
+
+    int line(char *buf)
+    {
+        if (fgets(buf, SESSION_LINE_MAX, fp) == NULL)
+            return -1;
+        buf[strcspn(buf, "\r\n")] = '\0';
+        return 1;
+    }
+
+public:
+    SessionLog()
+    {
+        pthread_mutex_init(&lock, NULL);
+    }
+
+    ~SessionLog()
+    {
+        Close();
+        pthread_mutex_destroy(&lock);
+    }
+
+    SessionLog(const SessionLog &) = delete;
+    SessionLog &operator=(const SessionLog &) = delete;
+
+    /**
+     * @brief Open for recording (`write`) or replay.
+     *
+     * @return int 1 on success, -1 if the file cannot be opened.
+     */
+    int Open(const char *fname, bool write)
+    {
+        Close();
+        fp = fopen(fname, write ? "w" : "r");
+        return fp == NULL ? -1 : 1;
+    }
+
+    void Close()
+    {
+        if (fp != NULL)
+            fclose(fp);
+        fp = NULL;
+    }
+
+    /**
+     * @brief Append one event, stamped with `dt`. Safe to call from several threads.
+     *
+     * @return int 1 on success, -1 if the log is not open.
+     */
+    int Record(const DateTime &dt, const session_event_t &ev)
+    {
+        if (fp == NULL)
+            return -1;
+        pthread_mutex_lock(&lock);
+        fprintf(fp, "%" PRId64 " ", dt.Ticks());
+        switch (ev.type)
+        {
+        case SESSION_START:
+            fprintf(fp, "START %.9f %.9f %.6f\n", ev.lat, ev.lon, ev.alt);
+            break;
+        case SESSION_TLE:
+            fprintf(fp, "TLE %d\n%s\n%s\n", ev.priority, ev.TLE1, ev.TLE2);
+            break;
+        case SESSION_REMOVE:
+            fprintf(fp, "REMOVE %d\n", ev.target);
+            break;
+        case SESSION_PRIORITY:
+            fprintf(fp, "PRIORITY %d %d\n", ev.target, ev.priority);
+            break;
+        case SESSION_OBS:
+            fprintf(fp, "OBS %.9f %.9f %.6f\n", ev.lat, ev.lon, ev.alt);
+            break;
+        default:
+            fprintf(fp, "END\n");
+            break;
+        }
+        fflush(fp);
+        pthread_mutex_unlock(&lock);
+        return 1;
+    }
+
+    /**
+     * @brief Read the next event of a log opened for replay.
+     *
+     * @return int 1 on success, 0 at the end of the file, -1 on a malformed line.
+     */
+    int Next(session_event_t &ev)
+    {
+        char buf[SESSION_LINE_MAX], kind[16];
+        memset(&ev, 0x0, sizeof(session_event_t));
+        if ((fp == NULL) || (line(buf) < 0))
+            return 0;
+        int off = 0;
+        if (sscanf(buf, "%" SCNd64 " %15s %n", &ev.ticks, kind, &off) < 2)
+            return -1;
+        const char *args = buf + off;
+        if (strcmp(kind, "START") == 0)
+        {
+            ev.type = SESSION_START;
+            return sscanf(args, "%lf %lf %lf", &ev.lat, &ev.lon, &ev.alt) == 3 ? 1 : -1;
+        }
+        if (strcmp(kind, "OBS") == 0)
+        {
+            ev.type = SESSION_OBS;
+            return sscanf(args, "%lf %lf %lf", &ev.lat, &ev.lon, &ev.alt) == 3 ? 1 : -1;
+        }
+        if (strcmp(kind, "TLE") == 0)
+        {
+            ev.type = SESSION_TLE;
+            if (sscanf(args, "%d", &ev.priority) != 1)
+                return -1;
+            if ((line(buf) < 0) || (strlen(buf) >= sizeof(ev.TLE1)))
+                return -1;
+            strcpy(ev.TLE1, buf);
+            if ((line(buf) < 0) || (strlen(buf) >= sizeof(ev.TLE2)))
+                return -1;
+            strcpy(ev.TLE2, buf);
+            return 1;
+        }
+        if (strcmp(kind, "REMOVE") == 0)
+        {
+            ev.type = SESSION_REMOVE;
+            return sscanf(args, "%d", &ev.target) == 1 ? 1 : -1;
+        }
+        if (strcmp(kind, "PRIORITY") == 0)
+        {
+            ev.type = SESSION_PRIORITY;
+            return sscanf(args, "%d %d", &ev.target, &ev.priority) == 2 ? 1 : -1;
+        }
+        if (strcmp(kind, "END") == 0)
+        {
+            ev.type = SESSION_END;
+            return 1;
+        }
+        return -1;
+    }
+};
+
+#endif // SESSION_LOG_HPP
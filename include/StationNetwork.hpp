@@ -0,0 +1,359 @@
+/**
+ * @file StationNetwork.hpp
+ * @brief Pass prediction and scheduling for every station of the network at once, in parallel.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * Predict() runs in three parallel stages over a pool of threads that pull work items from a
+ * shared counter:
+ *   1. each target is propagated once into a SatTrack covering the whole search,
+ *   2. each (station, target) pair is searched for passes from the shared track, with no
+ *      propagation at all,
+ *   3. each station's passes go through its own PassScheduler into a conflict-free timeline.
+ * Work items are independent, so the stages scale with the number of cores.
+ *
+ * Station files have one station per line, "lat, lon[, alt[, name]]", degrees and km, with
+ * '#' starting a comment (dish_pos.txt).
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef STATION_NETWORK_HPP
+#define STATION_NETWORK_HPP
+
+#include <PassPredictor.hpp>
+#include <PassScheduler.hpp>
+#include <SatTrack.hpp>
+#include <SGP4/CoordGeodetic.h>
+#include <SGP4/Observer.h>
+#include <SGP4/SGP4.h>
+#include <SGP4/Tle.h>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+#define STATION_NAME_MAX 32
+#define STATION_MAX_PASSES 1000 // per station and target
+
+typedef struct
+{
+    char name[STATION_NAME_MAX];
+    double lat;    // degrees
+    double lon;    // degrees
+    double alt;    // km
+    double el_min; // radians, elevation mask
+} station_t;
+
+/**
+ * @brief Wall time of each stage of the last Predict(), in seconds.
+ *
+ */
+typedef struct
+{
+    double propagate;
+    double predict;
+    double schedule;
+    int threads;
+} network_timing_t;
+
+class StationNetwork
+{
+private:
+    typedef struct
+    {
+        int id;
+        int priority;
+        SGP4 *sgp;
+        SatTrack track;
+    } target_t;
+
+    typedef struct
+    {
+        StationNetwork *net;
+        Observer obs; // GetLookAngle is not reentrant, one per scheduling thread
+    } look_ctx_t;
+
+    typedef void (*work_fn_t)(StationNetwork *net, size_t item);
+
+    typedef struct
+    {
+        StationNetwork *net;
+        work_fn_t fn;
+        size_t count;
+        std::atomic<size_t> *next;
+    } worker_t;
+
+    std::vector<station_t> stations;
+    std::vector<target_t> targets;
+    std::unordered_map<int, size_t> index;             // NORAD ID to target
+    std::vector<std::vector<pass_t>> passes;           // station * targets.size() + target
+    std::vector<std::vector<sched_entry_t>> timelines; // per station
+    DateTime from;
+    double horizon = 0;
+    network_timing_t timing;
+
+    static double now_s()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec + ts.tv_nsec * 1e-9;
+    }
+
+    static void *worker(void *p)
+    {
+        worker_t *w = (worker_t *)p;
+        size_t i;
+        while ((i = w->next->fetch_add(1, std::memory_order_relaxed)) < w->count)
+            w->fn(w->net, i);
+        return NULL;
+    }
+
+    /**
+     * @brief Run `fn` on items [0, count) with up to `nthreads` threads, the caller included.
+     *
+     */
+    void parallel(size_t count, int nthreads, work_fn_t fn)
+    {
+        std::atomic<size_t> next{0};
+        worker_t w = {this, fn, count, &next};
+        int extra = std::min((size_t)nthreads, count) - 1;
+        std::vector<pthread_t> tids;
+        for (int i = 0; i < extra; i++)
+        {
+            pthread_t tid;
+            if (pthread_create(&tid, NULL, worker, &w) == 0)
+                tids.push_back(tid);
+        }
+        worker(&w);
+        for (size_t i = 0; i < tids.size(); i++)
+            pthread_join(tids[i], NULL);
+    }
+
+    static void propagate_one(StationNetwork *net, size_t t)
+    {
+        double margin = PASS_MAX_LENGTH + STATION_TRACK_STEP;
+        target_t &tg = net->targets[t];
+        tg.track.Build(*tg.sgp, net->from.AddSeconds(-margin), net->from.AddSeconds(net->horizon + margin));
+    }
+
+    static void predict_one(StationNetwork *net, size_t k)
+    {
+        size_t s = k / net->targets.size(), t = k % net->targets.size();
+        const station_t &st = net->stations[s];
+        const target_t &tg = net->targets[t];
+        if (!tg.track.IsValid())
+        {
+            net->passes[k].clear();
+            return;
+        }
+        PassPredictor predictor(&tg.track, CoordGeodetic(st.lat, st.lon, st.alt), st.el_min);
+        predictor.FindPasses(net->from, net->horizon, STATION_MAX_PASSES, net->passes[k]);
+    }
+
+    static int look(void *ctx, int target, const DateTime &dt, CoordTopocentric *coord)
+    {
+        look_ctx_t *c = (look_ctx_t *)ctx;
+        auto it = c->net->index.find(target);
+        if ((it == c->net->index.end()) || !c->net->targets[it->second].track.IsValid())
+            return -1;
+        *coord = c->obs.GetLookAngle(c->net->targets[it->second].track.At(dt));
+        return 1;
+    }
+
+    static void schedule_one(StationNetwork *net, size_t s)
+    {
+        const station_t &st = net->stations[s];
+        look_ctx_t ctx = {net, Observer(CoordGeodetic(st.lat, st.lon, st.alt))};
+        PassScheduler scheduler(look, &ctx);
+        for (size_t t = 0; t < net->targets.size(); t++)
+            scheduler.SetPasses(net->targets[t].id, net->targets[t].priority, net->passes[s * net->targets.size() + t]);
+        net->timelines[s] = scheduler.Timeline();
+    }
+
+public:
+    StationNetwork()
+    {
+        memset(&timing, 0x0, sizeof(timing));
+    }
+
+    ~StationNetwork()
+    {
+        Clear();
+    }
+
+    StationNetwork(const StationNetwork &) = delete;
+    StationNetwork &operator=(const StationNetwork &) = delete;
+
+    /**
+     * @brief Read stations from `path`, with elevation mask `el_min` in radians.
+     *
+     * @return int Number of stations read, -1 if the file cannot be opened.
+     */
+    static int LoadStations(const char *path, double el_min, std::vector<station_t> &out)
+    {
+        FILE *fp = fopen(path, "r");
+        if (fp == NULL)
+            return -1;
+        out.clear();
+        char line[256];
+        while (fgets(line, sizeof(line), fp) != NULL)
+        {
+            char *hash = strchr(line, '#');
+            if (hash != NULL)
+                *hash = '\0';
+            station_t st;
+            memset(&st, 0x0, sizeof(st));
+            char name[STATION_NAME_MAX] = "";
+            int n = sscanf(line, " %lf , %lf , %lf , %31[^\n]", &st.lat, &st.lon, &st.alt, name);
+            if (n < 2)
+                continue;
+            if (n < 4)
+                snprintf(name, sizeof(name), "station %d", (int)out.size() + 1);
+            strcpy(st.name, name);
+            st.el_min = el_min;
+            out.push_back(st);
+        }
+        fclose(fp);
+        return out.size();
+    }
+
+    /**
+     * @brief Add a station.
+     *
+     * @return int Index of the station.
+     */
+    int AddStation(const station_t &st)
+    {
+        stations.push_back(st);
+        return stations.size() - 1;
+    }
+
+    /**
+     * @brief Add a target from its element lines.
+     *
+     * @return int Index of the target, -1 on invalid elements, -2 if the target is already in.
+     */
+    int AddTarget(const char *line1, const char *line2, int priority = 0)
+    {
+        SGP4 *sgp;
+        int id;
+        try
+        {
+            Tle tle(line1, line2);
+            id = tle.NoradNumber();
+            sgp = new SGP4(tle);
+        }
+        catch (std::exception &e)
+        {
+            return -1;
+        }
+        if (index.count(id) > 0)
+        {
+            delete sgp;
+            return -2;
+        }
+        index[id] = targets.size();
+        targets.push_back(target_t());
+        target_t &tg = targets.back();
+        tg.id = id;
+        tg.priority = priority;
+        tg.sgp = sgp;
+        return targets.size() - 1;
+    }
+
+    void Clear()
+    {
+        for (size_t t = 0; t < targets.size(); t++)
+            delete targets[t].sgp;
+        targets.clear();
+        index.clear();
+        stations.clear();
+        passes.clear();
+        timelines.clear();
+    }
+
+    /**
+     * @brief Predict and schedule passes starting within `horizon` seconds of `from` for every
+     * station and target.
+     *
+     * @param nthreads Worker threads, 0 for one per online CPU.
+     * @return int Windows scheduled over all stations, -1 without stations, targets or horizon.
+     */
+    int Predict(const DateTime &from, double horizon, int nthreads = 0)
+    {
+        if (stations.empty() || targets.empty() || (horizon <= 0))
+            return -1;
+        if (nthreads <= 0)
+            nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+        this->from = from;
+        this->horizon = horizon;
+        passes.assign(stations.size() * targets.size(), std::vector<pass_t>());
+        timelines.assign(stations.size(), std::vector<sched_entry_t>());
+        timing.threads = nthreads;
+
+        double t0 = now_s();
+        parallel(targets.size(), nthreads, propagate_one);
+        double t1 = now_s();
+        parallel(passes.size(), nthreads, predict_one);
+        double t2 = now_s();
+        parallel(stations.size(), nthreads, schedule_one);
+        double t3 = now_s();
+        timing.propagate = t1 - t0;
+        timing.predict = t2 - t1;
+        timing.schedule = t3 - t2;
+
+        int total = 0;
+        for (size_t s = 0; s < timelines.size(); s++)
+            total += timelines[s].size();
+        return total;
+    }
+
+    size_t Stations() const
+    {
+        return stations.size();
+    }
+
+    const station_t &Station(size_t s) const
+    {
+        return stations[s];
+    }
+
+    size_t Targets() const
+    {
+        return targets.size();
+    }
+
+    /**
+     * @brief Every pass of target index `t` over station `s`, from the last Predict().
+     *
+     */
+    const std::vector<pass_t> &Passes(size_t s, size_t t) const
+    {
+        return passes[s * targets.size() + t];
+    }
+
+    /**
+     * @brief The merged schedule of station `s`, sorted by start.
+     *
+     */
+    const std::vector<sched_entry_t> &Timeline(size_t s) const
+    {
+        return timelines[s];
+    }
+
+    network_timing_t Timing() const
+    {
+        return timing;
+    }
+};
+
+#endif // STATION_NETWORK_HPP
@@ -1,48 +1,730 @@
 /**
- * @file TrackingMotor.hpp
+ * @file TargetSystem.hpp
  * @author Sunip K. Mukherjee
- * @brief 
+ * @brief Tracked targets, the pass planner thread and the tracking tick that points the rotator.
  * @version See Git tags for version information.
  * @date 2021.08.16
- * 
+ *
  * @copyright Copyright (c) 2021
- * 
+ *
  */
 
 #ifndef TARGET_SYSTEM_HPP
 #define TARGET_SYSTEM_HPP
 
 #include <TrackingMotor.hpp>
+#include <Doppler.hpp>
+#include <PassEphemeris.hpp>
+#include <PassPlan.hpp>
+#include <PassPredictor.hpp>
+#include <PassScheduler.hpp>
+#include <PointingController.hpp>
+#include <RcuDomain.hpp>
+#include <SeqLock.hpp>
+#include <Telemetry.hpp>
+#include <Instrument.hpp>
+#include <TrackClock.hpp>
+#include <RingLog.hpp>
+#include <ScheduleStore.hpp>
+#include <TickScheduler.hpp>
 #include <SGP4/CoordTopocentric.h>
 #include <SGP4/Observer.h>
 #include <SGP4/SGP4.h>
 #include <pthread.h>
+#include <errno.h>
+#include <time.h>
+#include <algorithm>
+#include <exception>
+#include <utility>
+#include <vector>
 #include "meb_debug.h"
 #include "clkgen.h"
 
-#define LOOKAHEAD_TIME 60 // Seconds
+#define PASS_HORIZON 86400   // Seconds, how far ahead the planner searches
+#define PASS_PLAN_COUNT 16   // Most passes kept per target within the horizon
+#define PREPOSITION_TIME 180 // Seconds before AOS the dish is moved to the AOS azimuth
+#define PLANNER_PERIOD 60    // Seconds of tracker time between planner maintenance rounds
+#define TICK_ADAPT_STEP 0.1  // Degrees the dish may have to turn between adaptive ticks
+#define TICK_ADAPT_MAX 1     // Seconds, longest adaptive tick inside a window
+#define TICK_ADAPT_DT 0.1    // Seconds, difference step for the dish rate
+#define POSITION_PERIOD 1    // Seconds between ECI and geodetic updates while the pass table covers the tick
+#define TARGET_DEFAULT_PRIORITY 0
+
+/**
+ * @brief One element set of a target. Never modified once published; replaced as a whole and
+ * freed through the RCU domain when no reader can hold it any more.
+ *
+ */
+typedef struct
+{
+    SGP4 *sgp;
+    DateTime epoch;       // epoch of the element set
+    unsigned int version; // number of element sets this target has had
+    char line1[SCHED_STORE_LINE]; // the element lines, for the schedule store
+    char line2[SCHED_STORE_LINE];
+} tle_version_t;
+
+/**
+ * @brief One satellite the dish may be asked to follow.
+ *
+ */
+typedef struct
+{
+    int id;                  // NORAD ID
+    int priority;            // higher wins conflicts
+    tle_version_t *ver;      // current elements, swapped under the lock
+    bool dirty;              // passes need to be predicted again
+    DateTime predicted;      // passes are known up to here
+} target_t;
+
+/**
+ * @brief What the tracking tick computed, published once per tick for telemetry and other readers.
+ *
+ */
+typedef struct
+{
+    int64_t ticks;      // DateTime ticks of the sample
+    int target;         // NORAD ID, 0 if there is nothing to track
+    double eci[6];      // km and km/s, TEME
+    int64_t pos_ticks;  // DateTime ticks of eci, lat, lon and alt, 0 if not known
+    double az;          // degrees
+    double el;          // degrees
+    double range;       // km
+    double range_rate;  // km/s
+    double dl_doppler;  // Hz, offset of the received downlink, 0 without a downlink frequency
+    double ul_doppler;  // Hz, offset to add to the transmitted uplink, 0 without an uplink frequency
+    double lat;         // degrees
+    double lon;         // degrees
+    double alt;         // km
+    bool visible;       // inside a scheduled window
+    int mot_az;         // commanded azimuth, degrees
+    int mot_el;         // commanded elevation, degrees
+    double meas_az;     // reported azimuth, degrees, NAN without a recent report
+    double meas_el;     // reported elevation, degrees, NAN without a recent report
+} tracker_state_t;
 
 class TargetSystem
 {
 private:
-    SGP4 *sgp = nullptr;
+    std::vector<target_t> targets;
+    std::vector<int> removed; // targets the planner still has to drop from the schedule
     Observer *obs;
     TrackingMotor mot;
     pthread_mutex_t lock;
     bool ready = false;
-    bool targetVisible = true;
+    bool targetVisible = false;
     bool targetPrimed = false;
     int elevation_min = floor(0 * M_PI / 180);
+    PassEphemeris ephem;     // table for schedule[0]
+    PassEphemeris ephemNext; // table for schedule[1], swapped in at handover
+    PassPlan plan;           // rotator trajectory for schedule[0]
+    PassPlan planNext;       // rotator trajectory for schedule[1], swapped in at handover
+    plan_params_t plan_params;
+    bool ephemVerify = false;
+    ephem_error_t ephemErr = {0};
+    pthread_t planner_tid;
+    pthread_cond_t planner_cond;
+    bool planner_active = false;
+    bool replan = false;
+    bool planning = false;               // planner is working on a snapshot
+    pthread_cond_t idle_cond;            // signalled whenever the planner runs out of work
+    DateTime planner_due;                // next maintenance round
+    WallClock wall;
+    TrackClock *clock = &wall;
+    double tick_period = 1;              // seconds between TimerHandler calls
+    uint64_t last_tick = 0;              // instr_now() of the previous TimerHandler call
+    PointingController point;            // when and where to move the dish
+    unsigned int obs_generation = 0;     // bumped whenever the observer moves
+    DateTime position_due;               // next ECI and geodetic update while the table covers the tick
+    std::vector<sched_entry_t> schedule; // upcoming windows, schedule[0] is the one being tracked
+    SeqLock<tracker_state_t> state;      // written by Track() only
+    RcuDomain rcu;                       // element sets the planner may still be using
+    TelemetryRing telem;                 // one sample per tick, drained by the telemetry sender
+    radio_freq_t radio = {0, 0};         // links to publish Doppler shifts for
+    char store_path[4096] = "";          // schedule store, empty if not kept
+    tick_handler_t tick_wake = nullptr;  // called when the head of the schedule changes
+    void *tick_wake_ctx = nullptr;
+
+    typedef struct
+    {
+        int id;
+        int priority;
+        std::vector<pass_t> passes;
+    } restored_t;
+
+    std::vector<restored_t> restored; // passes from the schedule store, for the planner to take
+
+    typedef struct
+    {
+        Observer *obs;
+        std::vector<target_t> targets;
+    } planner_ctx_t;
+
+    target_t *findTarget(int id)
+    {
+        for (size_t i = 0; i < targets.size(); i++)
+            if (targets[i].id == id)
+                return &targets[i];
+        return nullptr;
+    }
+
+    /**
+     * @brief The target being tracked, or the first target if none is scheduled.
+     * Called with the lock held.
+     *
+     */
+    target_t *activeTarget()
+    {
+        target_t *t = nullptr;
+        if (schedule.size() > 0)
+            t = findTarget(schedule[0].target);
+        if ((t == nullptr) && (targets.size() > 0))
+            t = &targets[0];
+        return t;
+    }
+
+    /**
+     * @brief Rate of the faster rotator axis at `dt`, degrees per second. Called with the lock held.
+     *
+     * @return double Negative if the dish has nowhere to point.
+     */
+    double dishRate(const DateTime &dt)
+    {
+        double az0, el0, az1, el1;
+        if ((PointLook(this, dt, &az0, &el0) < 0) || (PointLook(this, dt.AddSeconds(TICK_ADAPT_DT), &az1, &el1) < 0))
+            return -1;
+        double daz = fabs(remainder(az1 - az0, 360.0));
+        double del = fabs(el1 - el0);
+        return std::max(daz, del) / TICK_ADAPT_DT;
+    }
+
+    /**
+     * @brief Propagate `t` to `dt`, for its look angle, its ECI and geodetic position, or both.
+     * Called with the lock held.
+     *
+     * @return int 1 on success, -2 if propagation failed.
+     */
+    int locate(target_t *t, const DateTime &dt, CoordTopocentric *coord, tracker_state_t *st)
+    {
+        try
+        {
+            Eci eci = t->ver->sgp->FindPosition(dt);
+            if (coord != nullptr)
+                *coord = obs->GetLookAngle(eci);
+            if (st != nullptr)
+            {
+                CoordGeodetic geo = eci.ToGeodetic();
+                st->eci[0] = eci.Position().x;
+                st->eci[1] = eci.Position().y;
+                st->eci[2] = eci.Position().z;
+                st->eci[3] = eci.Velocity().x;
+                st->eci[4] = eci.Velocity().y;
+                st->eci[5] = eci.Velocity().z;
+                st->lat = geo.latitude * 180 / M_PI;
+                st->lon = geo.longitude * 180 / M_PI;
+                st->alt = geo.altitude;
+                st->pos_ticks = dt.Ticks();
+                position_due = dt.AddSeconds(POSITION_PERIOD);
+            }
+        }
+        catch (std::exception &e)
+        {
+            return -2;
+        }
+        return 1;
+    }
+
+    /**
+     * @brief Look angle of the active target for this tick, from the pass table while it covers
+     * the tick. The ECI and geodetic position then only move every POSITION_PERIOD. Without a
+     * table the target is propagated on every tick. Called with the lock held.
+     *
+     * @return int 1 from the table, 2 propagated, negative if there is no target or propagation failed.
+     */
+    int sample(const DateTime &dt, tracker_state_t &st, CoordTopocentric &coord)
+    {
+        memset(&st, 0x0, sizeof(tracker_state_t));
+        st.ticks = dt.Ticks();
+        target_t *t = activeTarget();
+        if (t == nullptr)
+            return -1;
+        st.target = t->id;
+        int retval = 1;
+        tracker_state_t prev;
+        if ((schedule.size() == 0) || (t->id != schedule[0].target) || (ephem.Interpolate(dt, coord) < 0))
+        {
+            if (locate(t, dt, &coord, &st) < 0)
+                return -2;
+            retval = 2;
+        }
+        else if ((dt < position_due) && (state.Load(prev) > 0) && (prev.target == st.target) && (prev.pos_ticks <= st.ticks)) // carry the last position
+        {
+            memcpy(st.eci, prev.eci, sizeof(st.eci));
+            st.lat = prev.lat;
+            st.lon = prev.lon;
+            st.alt = prev.alt;
+            st.pos_ticks = prev.pos_ticks;
+        }
+        else
+            locate(t, dt, nullptr, &st); // the look angle stands without it
+        st.az = coord.azimuth * 180 / M_PI;
+        st.el = coord.elevation * 180 / M_PI;
+        st.range = coord.range;
+        st.range_rate = coord.range_rate;
+        return retval;
+    }
+
+    /**
+     * @brief Doppler shifts of this tick's range rate. Called with the lock held.
+     *
+     */
+    void doppler(tracker_state_t &st)
+    {
+        st.dl_doppler = doppler_downlink(radio.downlink, st.range_rate);
+        st.ul_doppler = doppler_uplink(radio.uplink, st.range_rate);
+    }
+
+    /**
+     * @brief Where the rotator should point for the target being tracked: the pass plan, or the
+     * raw look angle outside of it. For the pointing controller, called from Track() with the
+     * lock held.
+     *
+     */
+    static int PointLook(void *ctx, const DateTime &dt, double *az, double *el)
+    {
+        TargetSystem *sys = (TargetSystem *)ctx;
+        if (sys->plan.Look(dt, az, el) > 0)
+            return 1;
+        CoordTopocentric coord;
+        if (sys->ephem.Interpolate(dt, coord) < 0) // outside of the pass table, propagate
+        {
+            if (sys->schedule.size() == 0)
+                return -1;
+            target_t *t = sys->findTarget(sys->schedule[0].target);
+            if (t == nullptr)
+                return -1;
+            try
+            {
+                Eci eci = t->ver->sgp->FindPosition(dt);
+                coord = sys->obs->GetLookAngle(eci);
+            }
+            catch (std::exception &e)
+            {
+                return -2;
+            }
+        }
+        *az = coord.azimuth * 180 / M_PI;
+        *el = coord.elevation * 180 / M_PI;
+        return 1;
+    }
+
+    static int PlannerLook(void *ctx, int target, const DateTime &dt, CoordTopocentric *coord)
+    {
+        planner_ctx_t *pc = (planner_ctx_t *)ctx;
+        for (size_t i = 0; i < pc->targets.size(); i++)
+        {
+            if (pc->targets[i].id == target)
+            {
+                try
+                {
+                    Eci eci = pc->targets[i].ver->sgp->FindPosition(dt);
+                    *coord = pc->obs->GetLookAngle(eci);
+                }
+                catch (std::exception &e) // decayed
+                {
+                    return -2;
+                }
+                return 1;
+            }
+        }
+        return -1;
+    }
+
+    static int BuildTable(planner_ctx_t *pc, const sched_entry_t &entry, PassEphemeris &table)
+    {
+        for (size_t i = 0; i < pc->targets.size(); i++)
+        {
+            if (pc->targets[i].id != entry.target)
+                continue;
+            try
+            {
+                return table.Build(pc->targets[i].ver->sgp, pc->obs, entry.start.AddSeconds(-EPHEM_STEP), entry.end.AddSeconds(EPHEM_STEP), EPHEM_STEP);
+            }
+            catch (std::exception &e) // decays around the window, Track() propagates instead
+            {
+                table.Clear();
+                return -2;
+            }
+        }
+        table.Clear();
+        return -1;
+    }
+
+    /**
+     * @brief Write what the planner just computed to the schedule store.
+     *
+     * @return int 1 on success, -1 on error.
+     */
+    static int saveStore(const char *path, const CoordGeodetic &location, const planner_ctx_t &pc, const PassScheduler &sched, const DateTime &now, const std::vector<sched_entry_t> &upcoming, const PassEphemeris &table, const PassEphemeris &tableNext, const PassPlan &plan, const PassPlan &planNext)
+    {
+        ScheduleStore store;
+        store.Clear(location.latitude * 180 / M_PI, location.longitude * 180 / M_PI, location.altitude, now);
+        std::vector<pass_t> found;
+        for (size_t i = 0; i < pc.targets.size(); i++)
+        {
+            const target_t &t = pc.targets[i];
+            sched.GetPasses(t.id, found);
+            store.AddTarget(t.id, t.priority, t.ver->line1, t.ver->line2, t.ver->epoch, t.dirty ? now.AddSeconds(PASS_HORIZON) : t.predicted, found);
+        }
+        for (size_t i = 0; i < upcoming.size(); i++)
+        {
+            if (i == 0)
+                store.AddEntry(upcoming[i], &table, &plan);
+            else if (i == 1)
+                store.AddEntry(upcoming[i], &tableNext, &planNext);
+            else
+                store.AddEntry(upcoming[i]);
+        }
+        return store.Save(path);
+    }
+
+    /**
+     * @brief Pass search, scheduling and tabulation, run off the tracking tick. The scheduler
+     * belongs to this thread; the lock is only held to snapshot targets and to publish the
+     * near end of the timeline.
+     *
+     */
+    static void *PlannerThread(void *p)
+    {
+        TargetSystem *sys = (TargetSystem *)p;
+        Observer obs(0, 0, 0);
+        planner_ctx_t ctx;
+        ctx.obs = &obs;
+        PassScheduler sched(PlannerLook, &ctx);
+        unsigned int obs_gen = 0;
+        int slot = sys->rcu.Register();
+        if (slot < 0)
+        {
+            dbprintlf(FATAL "No RCU reader slot left for the planner");
+            return NULL;
+        }
+        pthread_mutex_lock(&sys->lock);
+        obs.SetLocation(sys->obs->GetLocation());
+        while (sys->planner_active)
+        {
+            if (!sys->replan) // Track() asks for maintenance every PLANNER_PERIOD
+            {
+                sys->planning = false;
+                pthread_cond_broadcast(&sys->idle_cond);
+                pthread_cond_wait(&sys->planner_cond, &sys->lock);
+                continue;
+            }
+            sys->replan = false;
+            sys->planning = true;
+            DateTime now = sys->clock->Now();
+            for (size_t i = 0; i < sys->targets.size(); i++)
+                if ((sys->targets[i].predicted - now).TotalSeconds() < PASS_HORIZON / 2)
+                    sys->targets[i].dirty = true;
+            sys->rcu.Enter(slot); // element sets in the snapshot stay alive until Exit()
+            ctx.targets = sys->targets;
+            for (size_t i = 0; i < sys->targets.size(); i++)
+                sys->targets[i].dirty = false;
+            std::vector<int> gone;
+            gone.swap(sys->removed);
+            std::vector<restored_t> seed;
+            seed.swap(sys->restored);
+            obs_gen = sys->obs_generation;
+            CoordGeodetic location = sys->obs->GetLocation();
+            plan_params_t params = sys->plan_params;
+            double dish_az = sys->mot.GetAz(), dish_el = sys->mot.GetEl();
+            PassPlan plan; // kept while its window stays at the head, the dish may be following it
+            int plan_target = -1;
+            DateTime plan_start;
+            if (sys->schedule.size() > 0)
+            {
+                plan = sys->plan;
+                plan_target = sys->schedule[0].target;
+                plan_start = sys->schedule[0].start;
+            }
+            pthread_mutex_unlock(&sys->lock);
+
+            obs.SetLocation(location);
+            for (size_t i = 0; i < seed.size(); i++) // passes of a previous run, still valid
+                sched.SetPasses(seed[i].id, seed[i].priority, seed[i].passes);
+            for (size_t i = 0; i < gone.size(); i++)
+                sched.RemoveTarget(gone[i]);
+            for (size_t i = 0; i < ctx.targets.size(); i++)
+            {
+                if (!ctx.targets[i].dirty)
+                    continue;
+                std::vector<pass_t> found;
+                PassPredictor predictor(ctx.targets[i].ver->sgp, location, sys->elevation_min);
+                try
+                {
+                    predictor.FindPasses(now, PASS_HORIZON, PASS_PLAN_COUNT, found);
+                }
+                catch (std::exception &e) // decays within the horizon, keep the passes before it
+                {
+                    rlogf(LOG_WARN, YELLOW_FG "Target %d decays within the horizon, %zu passes kept: %s", ctx.targets[i].id, found.size(), e.what());
+                }
+                sched.SetPasses(ctx.targets[i].id, ctx.targets[i].priority, found);
+            }
+            sched.Prune(now);
+            const std::vector<sched_entry_t> &timeline = sched.Timeline();
+            std::vector<sched_entry_t> upcoming(timeline.begin(), timeline.begin() + std::min<size_t>(timeline.size(), PASS_PLAN_COUNT));
+            PassEphemeris table, tableNext;
+            PassPlan planNext;
+            if (upcoming.size() > 0)
+            {
+                BuildTable(&ctx, upcoming[0], table);
+                if (!plan.IsValid() || (plan_target != upcoming[0].target) || (plan_start != upcoming[0].start))
+                    plan.Build(table, upcoming[0].start, upcoming[0].end, dish_az, dish_el, params);
+            }
+            else
+                plan.Clear();
+            if (upcoming.size() > 1)
+            {
+                BuildTable(&ctx, upcoming[1], tableNext);
+                plan.Look(plan.End(), &dish_az, &dish_el); // the next pass starts where this one ends
+                planNext.Build(tableNext, upcoming[1].start, upcoming[1].end, dish_az, dish_el, params);
+            }
+            if ((sys->store_path[0] != '\0') && (saveStore(sys->store_path, location, ctx, sched, now, upcoming, table, tableNext, plan, planNext) < 0))
+                rlogf(LOG_WARN, YELLOW_FG "Could not save the schedule to %s", sys->store_path);
+            sys->rcu.Exit(slot);
+            sys->rcu.Reclaim();
+
+            pthread_mutex_lock(&sys->lock);
+            if (obs_gen != sys->obs_generation) // observer moved while we were searching
+                continue;
+            for (size_t i = 0; i < ctx.targets.size(); i++)
+            {
+                target_t *t = sys->findTarget(ctx.targets[i].id);
+                if ((t != nullptr) && ctx.targets[i].dirty)
+                    t->predicted = now.AddSeconds(PASS_HORIZON);
+            }
+            if ((sys->schedule.size() == 0) || (upcoming.size() == 0) || (sys->schedule[0].target != upcoming[0].target) || (sys->schedule[0].start != upcoming[0].start))
+            {
+                sys->targetPrimed = false; // head of the schedule changed
+                sys->targetVisible = false;
+                if (sys->tick_wake != nullptr) // an adaptive tick may be asleep until the old head
+                    sys->tick_wake(sys->tick_wake_ctx);
+            }
+            sys->schedule.swap(upcoming);
+            std::swap(sys->ephem, table);
+            std::swap(sys->ephemNext, tableNext);
+            std::swap(sys->plan, plan);
+            std::swap(sys->planNext, planNext);
+            if (sys->schedule.size() > 0)
+            {
+                const plan_report_t &rep = sys->plan.Report();
+                rlogf(LOG_DEBUG, "Next window: target %d in %.0f seconds for %.0f seconds", sys->schedule[0].target, (sys->schedule[0].start - sys->clock->Now()).TotalSeconds(), (sys->schedule[0].end - sys->schedule[0].start).TotalSeconds());
+                rlogf(LOG_DEBUG, "Plan: %s%s, %d swings, %.0f seconds slewing, %.0f seconds lost", rep.mode == PLAN_OFFSET ? "offset" : "direct", rep.flip ? " flipped" : "", rep.swings, rep.slew, rep.loss);
+            }
+        }
+        sys->planning = false;
+        pthread_cond_broadcast(&sys->idle_cond);
+        pthread_mutex_unlock(&sys->lock);
+        sys->rcu.Unregister(slot);
+        return NULL;
+    }
+
+    static void freeVersion(void *p)
+    {
+        tle_version_t *v = (tle_version_t *)p;
+        delete v->sgp;
+        delete v;
+    }
+
+    /**
+     * @brief Parse and construct outside the lock, swap the element set in under it, and retire
+     * the old one after it is released.
+     *
+     * @return int 1 on success, 0 if the elements are already active, -1 on missing lines, -2 if
+     * the TLE does not parse, -3 if the TLE is older than the active one.
+     */
+    int updateTLE(const char *TLE1, const char *TLE2, bool set_priority, int priority)
+    {
+        if ((TLE1 == NULL) || (TLE2 == NULL))
+            return -1;
+        tle_version_t *ver = nullptr;
+        int id = 0;
+        try
+        {
+            Tle tle = Tle(TLE1, TLE2);
+            ver = new tle_version_t;
+            ver->sgp = new SGP4(tle);
+            ver->epoch = tle.Epoch();
+            ver->version = 1;
+            snprintf(ver->line1, sizeof(ver->line1), "%s", TLE1);
+            snprintf(ver->line2, sizeof(ver->line2), "%s", TLE2);
+            id = tle.NoradNumber();
+        }
+        catch (std::exception &e)
+        {
+            if (ver != nullptr)
+                delete ver;
+            rlogf(LOG_ERROR, RED_FG "Rejected TLE: %s", e.what());
+            return -2;
+        }
+        int retval = 1;
+        tle_version_t *old = nullptr;
+        pthread_mutex_lock(&lock);
+        target_t *t = findTarget(id);
+        if (t == nullptr)
+        {
+            target_t nt = {id, set_priority ? priority : TARGET_DEFAULT_PRIORITY, ver, true, DateTime()};
+            targets.push_back(nt);
+        }
+        else if (ver->epoch < t->ver->epoch) // stale update, keep what we have
+        {
+            old = ver;
+            retval = -3;
+        }
+        else
+        {
+            if (ver->epoch == t->ver->epoch) // same elements pushed again
+            {
+                old = ver;
+                retval = 0;
+            }
+            else
+            {
+                ver->version = t->ver->version + 1;
+                old = t->ver;
+                t->ver = ver;
+                t->dirty = true; // passes were found with the old elements
+            }
+            if (set_priority && (t->priority != priority))
+            {
+                t->priority = priority;
+                t->dirty = true;
+                retval = 1;
+            }
+        }
+        if ((t == nullptr) || t->dirty)
+        {
+            replan = true;
+            pthread_cond_signal(&planner_cond);
+        }
+        pthread_mutex_unlock(&lock);
+        if (retval == -3)
+            rlogf(LOG_WARN, YELLOW_FG "Rejected TLE for %d: epoch older than the active elements", id);
+        if (old == ver) // never published
+            freeVersion(old);
+        else
+            rcu.Retire(old, freeVersion);
+        return retval;
+    }
+
+    /**
+     * @brief Resume from the schedule store: targets and their elements, their passes, the
+     * upcoming windows and the tables and plans of the first two. Passes are only taken for
+     * this station and for elements that are still the active ones; the planner recomputes
+     * everything else in the background. Called from Create() before the planner starts.
+     *
+     * @return int Windows restored, -1 if the store cannot be read, -2 if it was made for
+     * another station.
+     */
+    int restore()
+    {
+        ScheduleStore store;
+        if (store.Open(store_path) < 0)
+            return -1;
+        CoordGeodetic here = obs->GetLocation();
+        if (!store.Matches(here.latitude * 180 / M_PI, here.longitude * 180 / M_PI, here.altitude))
+            return -2;
+        std::vector<int> valid;
+        for (int i = 0; i < store.Targets(); i++)
+        {
+            const sched_store_target_t *rec = store.Target(i);
+            if (updateTLE(rec->line1, rec->line2, true, rec->priority) < 0) // older than what we were given
+                continue;
+            pthread_mutex_lock(&lock);
+            target_t *t = findTarget(rec->id);
+            if ((t != nullptr) && (t->ver->epoch.Ticks() == rec->epoch))
+            {
+                restored_t r;
+                r.id = rec->id;
+                r.priority = rec->priority;
+                store.Passes(i, r.passes);
+                restored.push_back(r);
+                t->dirty = false;
+                t->predicted = DateTime(rec->predicted);
+                valid.push_back(rec->id);
+            }
+            pthread_mutex_unlock(&lock);
+        }
+        DateTime now = clock->Now();
+        pthread_mutex_lock(&lock);
+        schedule.clear();
+        for (int i = 0; i < store.Entries(); i++)
+        {
+            sched_entry_t e = store.Entry(i);
+            if ((e.end < now) || (std::find(valid.begin(), valid.end(), e.target) == valid.end()))
+                continue;
+            if (schedule.size() < 2)
+            {
+                store.Table(i, schedule.size() == 0 ? ephem : ephemNext);
+                store.Plan(i, schedule.size() == 0 ? plan : planNext);
+            }
+            schedule.push_back(e);
+        }
+        int retval = schedule.size();
+        pthread_mutex_unlock(&lock);
+        return retval;
+    }
 
 public:
     TargetSystem() : obs(new Observer(0, 0, 0))
     {
+        pthread_mutex_init(&lock, NULL);
+        pthread_cond_init(&planner_cond, NULL);
+        pthread_cond_init(&idle_cond, NULL);
+        plan_params.limits.az_rate = ROTATOR_AZ_RATE;
+        plan_params.limits.el_rate = ROTATOR_EL_RATE;
+        plan_params.limits.settle = ROTATOR_SETTLE;
+        plan_params.range.az_min = ROTATOR_AZ_MIN;
+        plan_params.range.az_max = ROTATOR_AZ_MAX;
+        plan_params.range.el_max = ROTATOR_EL_MAX;
+        plan_params.beamwidth = POINT_BEAMWIDTH;
+    }
+
+    ~TargetSystem()
+    {
+        if (planner_active)
+        {
+            pthread_mutex_lock(&lock);
+            planner_active = false;
+            pthread_cond_signal(&planner_cond);
+            pthread_mutex_unlock(&lock);
+            pthread_join(planner_tid, NULL);
+        }
+        pthread_cond_destroy(&planner_cond);
+        pthread_cond_destroy(&idle_cond);
+        pthread_mutex_destroy(&lock);
+        for (size_t i = 0; i < targets.size(); i++)
+            freeVersion(targets[i].ver);
+        delete obs;
+    }
+
+    /**
+     * @brief Serial speed and controller dialect (motor_proto_t) of the rotator. Call before
+     * Create().
+     *
+     * @return int 1 on success, -1 if either is not supported.
+     */
+    int SetMotor(int baud, int proto)
+    {
+        return mot.Configure(baud, proto);
+    }
+
+    motor_stats_t GetMotorStats()
+    {
+        return mot.GetStats();
     }
 
     int Create(const char *devname, const char *TLE1, const char *TLE2, double lat, double lon, double alt)
     {
-        memset(&lock, 0x0, sizeof(pthread_mutex_t));
-        mot = TrackingMotor();
         int retval = 0;
         if ((TLE1 == NULL) || (TLE2 == NULL))
             return -2;
@@ -52,142 +734,481 @@ public:
             retval = mot.Open(devname);
         if (retval < 0)
             return -1;
-        Tle tle = Tle(TLE1, TLE2);
         obs->SetLocation(CoordGeodetic(lat, lon, alt));
-        sgp = new SGP4(tle);
+        if (updateTLE(TLE1, TLE2, false, 0) < 0)
+            return -2;
+        if (store_path[0] != '\0')
+        {
+            int count = restore();
+            if (count >= 0)
+                rlogf(LOG_INFO, "Resumed %d windows from %s", count, store_path);
+        }
+        planner_active = true;
+        replan = true;
+        if (pthread_create(&planner_tid, NULL, PlannerThread, this) != 0)
+        {
+            planner_active = false;
+            return -3;
+        }
         ready = true;
         return 1;
     }
     int Create(const char *TLE1, const char *TLE2, double lat, double lon, double alt)
     {
-        memset(&lock, 0x0, sizeof(pthread_mutex_t));
-        mot = TrackingMotor();
-        int retval = 0;
-        if ((TLE1 == NULL) || (TLE2 == NULL))
-            return -2;
-        retval = mot.Open();
-        if (retval < 0)
+        return Create(NULL, TLE1, TLE2, lat, lon, alt);
+    }
+    /**
+     * @brief Keep the planner's work in `path`, rewritten after every planning round, and
+     * resume from it in Create(). NULL stops keeping it. Call before Create().
+     *
+     * @return int 1 on success, -1 if the path is too long.
+     */
+    int SetStore(const char *path)
+    {
+        if (path == NULL)
+        {
+            store_path[0] = '\0';
+            return 1;
+        }
+        if (snprintf(store_path, sizeof(store_path), "%s", path) >= (int)sizeof(store_path))
+        {
+            store_path[0] = '\0';
             return -1;
-        Tle tle = Tle(TLE1, TLE2);
-        obs->SetLocation(CoordGeodetic(lat, lon, alt));
-        sgp = new SGP4(tle);
-        ready = true;
+        }
         return 1;
     }
+    /**
+     * @brief Replace the system clock, e.g. with a VirtualClock for simulation. Call before
+     * Create(); the clock must outlive the target system.
+     *
+     */
+    void SetClock(TrackClock *clk)
+    {
+        clock = clk == nullptr ? &wall : clk;
+    }
+    /**
+     * @brief CPU time the planner thread has used so far.
+     *
+     * @return double Seconds, negative if the planner is not running.
+     */
+    double GetPlannerCpu()
+    {
+        clockid_t cid;
+        struct timespec ts;
+        if (!planner_active || (pthread_getcpuclockid(planner_tid, &cid) != 0) || (clock_gettime(cid, &ts) != 0))
+            return -1;
+        return ts.tv_sec + ts.tv_nsec * 1e-9;
+    }
+    /**
+     * @brief Period of the tracking tick (TimerHandler or TickHandler), the reference for tick
+     * jitter and for the pointing controller's look-ahead.
+     *
+     */
+    void SetTickPeriod(double seconds)
+    {
+        pthread_mutex_lock(&lock);
+        tick_period = seconds;
+        point.SetPeriod(seconds);
+        pthread_mutex_unlock(&lock);
+    }
+    /**
+     * @brief Called from the planner whenever the head of the schedule changes, so an adaptive
+     * tick does not sleep through it, e.g. TickScheduler::WakeHandler.
+     *
+     */
+    void SetTickWake(tick_handler_t fn, void *ctx)
+    {
+        pthread_mutex_lock(&lock);
+        tick_wake = fn;
+        tick_wake_ctx = ctx;
+        pthread_mutex_unlock(&lock);
+    }
+    /**
+     * @brief Seconds until the tracking tick is next needed, for adaptive scheduling. Inside a
+     * window, TICK_ADAPT_STEP of dish motion at its predicted rate, at most TICK_ADAPT_MAX;
+     * outside, nothing until pre-positioning, AOS or the next planner round. The pointing
+     * look-ahead is set to the same interval.
+     *
+     */
+    double NextTick()
+    {
+        pthread_mutex_lock(&lock);
+        DateTime dt = clock->Now();
+        double next = TICK_ADAPT_MAX;
+        if (ready)
+        {
+            next = (planner_due - dt).TotalSeconds();
+            if (schedule.size() > 0)
+            {
+                double aos = (schedule[0].start - dt).TotalSeconds();
+                if (aos > PREPOSITION_TIME)
+                    next = std::min(next, aos - PREPOSITION_TIME);
+                else if (aos > 0)
+                    next = std::min(next, aos);
+                else
+                {
+                    double rate = dishRate(dt);
+                    next = std::min(next, rate > TICK_ADAPT_STEP / TICK_ADAPT_MAX ? TICK_ADAPT_STEP / rate : TICK_ADAPT_MAX);
+                    next = std::min(next, (schedule[0].end - dt).TotalSeconds() + 1.0 / TICK_RATE_MAX); // hand over at LOS
+                }
+            }
+        }
+        next = std::max(next, 1.0 / TICK_RATE_MAX);
+        point.SetPeriod(next);
+        pthread_mutex_unlock(&lock);
+        return next;
+    }
+    /**
+     * @brief Full beamwidth of the antenna in degrees and the delay from a motor command to the
+     * rotator moving, in seconds. Setpoints are only sent when the target would leave half the
+     * beamwidth.
+     *
+     */
+    void SetBeam(double beamwidth, double latency)
+    {
+        pthread_mutex_lock(&lock);
+        point.SetBeam(beamwidth, latency);
+        plan_params.beamwidth = beamwidth;
+        pthread_mutex_unlock(&lock);
+    }
+    /**
+     * @brief Block until the planner has nothing left to do. With a virtual clock this keeps
+     * simulation deterministic: step the clock, Track(), WaitPlanner().
+     *
+     */
+    void WaitPlanner()
+    {
+        pthread_mutex_lock(&lock);
+        while (planner_active && (replan || planning))
+            pthread_cond_wait(&idle_cond, &lock);
+        pthread_mutex_unlock(&lock);
+    }
+    /**
+     * @brief Add a target, or replace the elements of the target with the same NORAD ID.
+     * The target keeps its priority. Elements older than the active ones are rejected.
+     *
+     * @return int 1 on success, 0 if these elements are already active, -1 on missing lines,
+     * -2 if the TLE does not parse, -3 if the TLE epoch is older than the active one.
+     */
     int UpdateTLE(const char *TLE1, const char *TLE2)
     {
-        if ((TLE1 != NULL) && (TLE2 != NULL))
+        return updateTLE(TLE1, TLE2, false, 0);
+    }
+    int UpdateTLE(const char *TLE1, const char *TLE2, int priority)
+    {
+        return updateTLE(TLE1, TLE2, true, priority);
+    }
+    int SetPriority(int id, int priority)
+    {
+        int retval = -1;
+        pthread_mutex_lock(&lock);
+        target_t *t = findTarget(id);
+        if (t != nullptr)
         {
-            pthread_mutex_lock(&lock);
-            Tle tle = Tle(TLE1, TLE2);
-            sgp = new SGP4(tle);
-            pthread_mutex_unlock(&lock);
-            return 1;
+            t->priority = priority;
+            t->dirty = true;
+            replan = true;
+            pthread_cond_signal(&planner_cond);
+            retval = 1;
         }
-        else
-            return -1;
+        pthread_mutex_unlock(&lock);
+        return retval;
+    }
+    int RemoveTarget(int id)
+    {
+        int retval = -1;
+        tle_version_t *old = nullptr;
+        pthread_mutex_lock(&lock);
+        for (size_t i = 0; i < targets.size(); i++)
+        {
+            if (targets[i].id == id)
+            {
+                old = targets[i].ver;
+                targets.erase(targets.begin() + i);
+                removed.push_back(id);
+                replan = true;
+                pthread_cond_signal(&planner_cond);
+                retval = 1;
+                break;
+            }
+        }
+        pthread_mutex_unlock(&lock);
+        rcu.Retire(old, freeVersion);
+        return retval;
     }
     int UpdateObs(double lat, double lon, double alt)
     {
         pthread_mutex_lock(&lock);
         obs->SetLocation(CoordGeodetic(lat, lon, alt));
+        obs_generation++;
+        for (size_t i = 0; i < targets.size(); i++) // every pass moves with the observer
+            targets[i].dirty = true;
+        ephem.Clear();
+        ephemNext.Clear();
+        plan.Clear();
+        planNext.Clear();
+        schedule.clear();
+        targetPrimed = false;
+        targetVisible = false;
+        replan = true;
+        pthread_cond_signal(&planner_cond);
+        pthread_mutex_unlock(&lock);
+        return 1;
+    }
+    /**
+     * @brief Copy of the near end of the schedule, the first entry is being tracked.
+     *
+     * @return int Number of entries.
+     */
+    int GetSchedule(std::vector<sched_entry_t> &out)
+    {
+        pthread_mutex_lock(&lock);
+        out = schedule;
+        pthread_mutex_unlock(&lock);
+        return out.size();
+    }
+    /**
+     * @brief How the rotator will fly the window being tracked (or next up).
+     *
+     * @return int 1 on success, -1 if there is no plan yet.
+     */
+    int GetPlan(plan_report_t &out)
+    {
+        pthread_mutex_lock(&lock);
+        int retval = plan.IsValid() ? 1 : -1;
+        out = plan.Report();
+        pthread_mutex_unlock(&lock);
+        return retval;
+    }
+    /**
+     * @brief Link frequencies in Hz to publish Doppler shifts for, 0 for a link that is not used.
+     *
+     * @return int 1 on success, -1 on a negative frequency.
+     */
+    int SetRadio(double uplink, double downlink)
+    {
+        if ((uplink < 0) || (downlink < 0))
+            return -1;
+        pthread_mutex_lock(&lock);
+        radio.uplink = uplink;
+        radio.downlink = downlink;
         pthread_mutex_unlock(&lock);
         return 1;
     }
+    /**
+     * @brief Also propagate directly on every interpolated tick and record the difference.
+     *
+     */
+    void SetEphemerisVerify(bool enable)
+    {
+        pthread_mutex_lock(&lock);
+        ephemVerify = enable;
+        memset(&ephemErr, 0x0, sizeof(ephem_error_t));
+        pthread_mutex_unlock(&lock);
+    }
+    ephem_error_t GetEphemerisError()
+    {
+        pthread_mutex_lock(&lock);
+        ephem_error_t err = ephemErr;
+        pthread_mutex_unlock(&lock);
+        return err;
+    }
+    /**
+     * @brief Latest state published by the tracking tick. Never blocks and never propagates.
+     *
+     * @return uint32_t Number of ticks published so far, 0 if the tracker has not run yet.
+     */
+    uint32_t GetState(tracker_state_t &st) const
+    {
+        return state.Load(st);
+    }
+    /**
+     * @brief Take up to `max` telemetry samples, oldest first. Only one thread may drain.
+     *
+     * @return int Number of samples copied.
+     */
+    int ReadTelemetry(telem_sample_t *out, int max)
+    {
+        return telem.Pop(out, max);
+    }
+    /**
+     * @brief Telemetry samples lost to a full ring since the last call.
+     *
+     */
+    uint32_t TelemetryDropped()
+    {
+        return telem.TakeDropped();
+    }
     CoordTopocentric GetPosition()
     {
-        DateTime dt = DateTime::Now(true);                                     // current time
-        Eci eci = sgp->FindPosition(dt);
-        CoordTopocentric coord = obs->GetLookAngle(eci);
-        coord.elevation *= 180 / M_PI;
-        coord.azimuth *= 180 / M_PI;
+        tracker_state_t st;
+        state.Load(st);
+        CoordTopocentric coord;
+        coord.azimuth = st.az;
+        coord.elevation = st.el;
+        coord.range = st.range;
+        coord.range_rate = st.range_rate;
         return coord;
     }
     CoordGeodetic GetGeoPosition()
     {
-        DateTime dt = DateTime::Now(true);                                     // current time
-        Eci eci = sgp->FindPosition(dt);
-        CoordGeodetic geocoord = eci.ToGeodetic();
-        geocoord.latitude *= 180 / M_PI;
-        geocoord.longitude *= 180 / M_PI;
-        return geocoord;
+        tracker_state_t st;
+        state.Load(st);
+        CoordGeodetic geo; // degrees as published, the constructor would convert them
+        geo.latitude = st.lat;
+        geo.longitude = st.lon;
+        geo.altitude = st.alt;
+        return geo;
     }
     int Track()
     {
         int retval = 0;
-        if (ready)
+        if (!ready)
+            return retval;
+        uint64_t tick_start = instr_now();
+        pthread_mutex_lock(&lock);
+        instruments().Since(INSTR_LOCK_WAIT, tick_start);
+        DateTime dt = clock->Now(); // current time
+        if (dt >= planner_due) // prune, and extend predictions running short of the horizon
         {
-            pthread_mutex_lock(&lock);
-            DateTime dt = DateTime::Now(true);                                     // current time
-            Eci eci = sgp->FindPosition(dt);                                       // find position now
-            CoordTopocentric coord = obs->GetLookAngle(eci);                       // find look angle
-#ifdef TARGET_SYS_DEBUG
-            dbprintlf("Target: %d %d, visible: %s", (int)(coord.azimuth * 180 / M_PI), (int)(coord.elevation * 180 / M_PI), targetVisible ? "YES" : "NO ");
-#endif
-            if (targetVisible) // target is already visible
+            planner_due = dt.AddSeconds(PLANNER_PERIOD);
+            replan = true;
+            pthread_cond_signal(&planner_cond);
+        }
+        tracker_state_t st;
+        CoordTopocentric coord;
+        int sampled = sample(dt, st, coord); // table or one propagation per tick, shared with readers
+        if (schedule.size() == 0) // planner has nothing for us yet
+            goto ret;
+        if (dt > schedule[0].end) // window over, hand over to the next target
+        {
+            schedule.erase(schedule.begin());
+            std::swap(ephem, ephemNext);
+            ephemNext.Clear();
+            std::swap(plan, planNext);
+            planNext.Clear();
+            targetVisible = false;
+            targetPrimed = false;
+            replan = true; // tabulate the window after the new head
+            pthread_cond_signal(&planner_cond);
+            if ((schedule.size() == 0) || ((schedule[0].start - dt).TotalSeconds() > PREPOSITION_TIME))
+            {
+                mot.SetEl(90); // parked position
+                point.Commanded(dt, mot.GetAz(), 90);
+            }
+            retval = 1;
+            goto ret;
+        }
+        if (dt < schedule[0].start) // before the window, pre-position once we are close
+        {
+            if (!targetPrimed && ((schedule[0].start - dt).TotalSeconds() <= PREPOSITION_TIME))
             {
-                if (coord.elevation < elevation_min) // outside of look zone
+                targetPrimed = true;
+                double az, el;
+                if (plan.Look(schedule[0].start, &az, &el) > 0) // on the side of the stops the plan chose
+                    mot.SetPosition(round(az), round(el));
+                else
                 {
-                    targetVisible = false; // mark target invisible
-                    retval = 1;
-                    mot.SetEl(90); // parked position
-                    goto ret;
+                    mot.SetAz(schedule[0].start_az * 180 / M_PI);
+                    mot.SetEl(std::max(schedule[0].start_el, (double)elevation_min) * 180 / M_PI);
                 }
-                int retval = 0;
-                if ((int)(coord.azimuth * 180 / M_PI) != mot.GetAz()) // set azimuth
-                    retval = mot.SetAz(coord.azimuth * 180 / M_PI);
-                if (retval < 0)
-                    dbprintlf("Error setting azimuth, %d", retval);
-                if ((int)(coord.elevation * 180 / M_PI) != mot.GetEl()) // set elevation
-                    mot.SetEl(coord.elevation * 180 / M_PI);
-                if (retval < 0)
-                    dbprintlf("Error setting elevation, %d", retval);
-
-                retval = 1;
-                goto ret;
+                point.Commanded(dt, mot.GetAz(), mot.GetEl());
+                rlogf(LOG_DEBUG, "Target %d primed: %d %d, AOS in %.0f seconds", schedule[0].target, (int)(schedule[0].start_az * 180 / M_PI), (int)(schedule[0].start_el * 180 / M_PI), (schedule[0].start - dt).TotalSeconds());
             }
-            else if (targetPrimed) // target primed, not tracking yet
-            {
-                if (coord.elevation >= elevation_min)
-                    targetVisible = true;
+            retval = 1;
+            goto ret;
+        }
+        {
+            targetVisible = true;
+            bool current = (sampled > 0) && (st.target == schedule[0].target);
+            if (!current && (ephem.Interpolate(dt, coord) < 0)) // removed, wait for the planner to catch up
                 goto ret;
+            if (ephemVerify && (sampled == 1)) // measure what the table costs us in accuracy
+            {
+                CoordTopocentric exact;
+                if (locate(activeTarget(), dt, &exact, nullptr) > 0)
+                    PassEphemeris::AccumulateError(coord, exact, &ephemErr);
             }
-            else // search when, within the lookahead time, it will come over horizon and move to that target
+            rlogf(LOG_DEBUG, "Target %d: %d %d, visible: %s", schedule[0].target, (int)(coord.azimuth * 180 / M_PI), (int)(coord.elevation * 180 / M_PI), targetVisible ? "YES" : "NO ");
+            double az, el, age;
+            if (mot.GetPosition(&az, &el, &age) > 0) // start from where the dish really is
+                point.Measured(dt.AddSeconds(-age), az, el);
+            if (point.Update(dt, PointLook, this, &az, &el) > 0) // only when the target would leave the beam
             {
-                DateTime dt2 = dt.AddSeconds(LOOKAHEAD_TIME);
-                eci = sgp->FindPosition(dt2);
-                coord = obs->GetLookAngle(eci);
-                int seconds = 0;
-                do
-                {
-                    dt = dt.AddSeconds(1);
-                    seconds++;
-                    eci = sgp->FindPosition(dt);
-                    coord = obs->GetLookAngle(eci);
-                } while ((coord.elevation < elevation_min) && (seconds < LOOKAHEAD_TIME));
-                if (coord.elevation >= elevation_min)
-                {
-                    targetPrimed = true;
-                    mot.SetEl(coord.elevation);
-                    mot.SetAz(coord.azimuth);
-                }
-#ifdef TARGET_SYS_DEBUG
-                dbprintlf("Target: %d %d after %d seconds", (int)(coord.azimuth * 180 / M_PI), (int)(coord.elevation * 180 / M_PI), seconds);
-#endif
-                retval = 1;
-                goto ret;
+                int err = mot.SetPosition(az, el); // skipped if already commanded and reached
+                if (err < 0)
+                    rlogf(LOG_INFO, "Error setting position, %d", err);
             }
-            pthread_mutex_unlock(&lock);
         }
+        retval = 1;
     ret:
+        if (sampled > 0)
+            doppler(st);
+        st.visible = targetVisible;
+        st.mot_az = mot.GetAz();
+        st.mot_el = mot.GetEl();
+        {
+            double age;
+            if (mot.GetPosition(&st.meas_az, &st.meas_el, &age) <= 0)
+                st.meas_az = st.meas_el = NAN;
+        }
         pthread_mutex_unlock(&lock);
+        state.Store(st);
+        {
+            telem_sample_t ts;
+            ts.time_us = st.ticks - TELEM_UNIX_EPOCH * 1000000LL;
+            ts.target = st.target;
+            ts.cmd_az = st.mot_az;
+            ts.cmd_el = st.mot_el;
+            ts.pred_az = st.az;
+            ts.pred_el = st.el;
+            ts.range_rate = st.range_rate;
+            ts.range = st.range;
+            ts.dl_doppler = st.dl_doppler;
+            ts.ul_doppler = st.ul_doppler;
+            ts.flags = (st.visible ? TELEM_FLAG_VISIBLE : 0) | (sampled > 0 ? TELEM_FLAG_PREDICT : 0);
+            uint64_t tick_ns = instr_now() - tick_start;
+            ts.latency_us = tick_ns / 1000;
+            telem.Push(ts);
+            instruments().Record(INSTR_TRACK, tick_ns);
+        }
         return retval;
     }
+    /**
+     * @brief Tick of the built-in TickScheduler, which records the jitter itself against its
+     * absolute deadlines.
+     *
+     */
+    static void TickHandler(void *p)
+    {
+        ((TargetSystem *)p)->Track();
+    }
+
+    /**
+     * @brief Interval function of an adaptive TickScheduler.
+     *
+     */
+    static double TickInterval(void *p)
+    {
+        return ((TargetSystem *)p)->NextTick();
+    }
+
+    /**
+     * @brief Tick of the clkgen timer, jitter measured between callbacks.
+     *
+     */
     static void TimerHandler(clkgen_t clk, void *p)
     {
         TargetSystem *sys = (TargetSystem *)p;
+        uint64_t now = instr_now();
+        if (sys->last_tick != 0)
+        {
+            int64_t late = (int64_t)(now - sys->last_tick) - (int64_t)(sys->tick_period * 1e9);
+            instruments().Record(INSTR_TICK_JITTER, late < 0 ? -late : late);
+        }
+        sys->last_tick = now;
         sys->Track();
     }
 };
 
-#endif
\ No newline at end of file
+#endif
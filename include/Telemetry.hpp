@@ -0,0 +1,193 @@
+/**
+ * @file Telemetry.hpp
+ * @brief Pointing telemetry samples, the ring they wait in, and their batched wire layout.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * Wire layout of a TRACKING_DATA payload, little endian, no padding:
+ *   telem_header_t, then `count` telem_wire_t samples.
+ * Readers must check `version` and step through samples by `sample_size`, so fields can be
+ * appended to telem_wire_t without breaking older readers.
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef TELEMETRY_HPP
+#define TELEMETRY_HPP
+
+#include <atomic>
+#include <stdint.h>
+#include <string.h>
+
+#define TELEM_VERSION 1
+#define TELEM_RING_SIZE 1024            // samples, power of two; 100 s of 10 Hz ticks
+#define TELEM_UNIX_EPOCH 62135596800LL  // seconds from DateTime's epoch (0001-01-01) to 1970-01-01
+
+#define TELEM_FLAG_VISIBLE 0x1 // inside a scheduled window
+#define TELEM_FLAG_PREDICT 0x2 // predicted angles are valid
+
+/**
+ * @brief One tracking tick, as the tracker records it.
+ *
+ */
+typedef struct
+{
+    int64_t time_us;     // microseconds since the Unix epoch
+    int target;          // NORAD ID
+    float cmd_az;        // degrees, sent to the motor
+    float cmd_el;        // degrees
+    float pred_az;       // degrees, predicted for this tick
+    float pred_el;       // degrees
+    float range_rate;    // km/s
+    float range;         // km
+    float dl_doppler;    // Hz, offset of the received downlink
+    float ul_doppler;    // Hz, offset to add to the transmitted uplink
+    uint32_t latency_us; // time spent in the tick
+    uint16_t flags;      // TELEM_FLAG_*
+} telem_sample_t;
+
+#pragma pack(push, 1)
+typedef struct
+{
+    uint8_t version;     // TELEM_VERSION
+    uint8_t sample_size; // sizeof(telem_wire_t) of the sender
+    uint16_t count;      // samples that follow
+    uint32_t dropped;    // samples lost to a full ring since the last frame
+    int64_t t0_us;       // microseconds since the Unix epoch, samples are relative to this
+} telem_header_t;
+
+typedef struct
+{
+    uint32_t dt_us;      // since t0_us
+    int32_t target;
+    float cmd_az;
+    float cmd_el;
+    float pred_az;
+    float pred_el;
+    float range_rate;
+    uint16_t latency_us; // saturates at 65535
+    uint16_t flags;
+    float range;
+    float dl_doppler;
+    float ul_doppler;
+} telem_wire_t;
+#pragma pack(pop)
+
+/**
+ * @brief Single-producer single-consumer ring. The tracking tick pushes, the sender pops.
+ * Neither side ever blocks; the producer drops samples when the ring is full.
+ *
+ */
+class TelemetryRing
+{
+private:
+    telem_sample_t ring[TELEM_RING_SIZE];
+    std::atomic<uint32_t> head; // next slot to write
+    std::atomic<uint32_t> tail; // next slot to read
+    std::atomic<uint32_t> dropped;
+
+public:
+    TelemetryRing() : head(0), tail(0), dropped(0) {}
+
+    TelemetryRing(const TelemetryRing &) = delete;
+    TelemetryRing &operator=(const TelemetryRing &) = delete;
+
+    /**
+     * @brief Append one sample. Producer side only.
+     *
+     * @return int 1 on success, -1 if the ring is full.
+     */
+    int Push(const telem_sample_t &s)
+    {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) >= TELEM_RING_SIZE)
+        {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return -1;
+        }
+        ring[h & (TELEM_RING_SIZE - 1)] = s;
+        head.store(h + 1, std::memory_order_release);
+        return 1;
+    }
+
+    /**
+     * @brief Take up to `max` samples, oldest first. Consumer side only.
+     *
+     * @return int Number of samples copied.
+     */
+    int Pop(telem_sample_t *out, int max)
+    {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        uint32_t n = head.load(std::memory_order_acquire) - t;
+        if (n > (uint32_t)max)
+            n = max;
+        for (uint32_t i = 0; i < n; i++)
+            out[i] = ring[(t + i) & (TELEM_RING_SIZE - 1)];
+        tail.store(t + n, std::memory_order_release);
+        return n;
+    }
+
+    /**
+     * @brief Samples dropped since the last call. Consumer side only.
+     *
+     */
+    uint32_t TakeDropped()
+    {
+        return dropped.exchange(0, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Most samples a payload of `size` bytes can carry.
+     *
+     */
+    static int BatchMax(int size)
+    {
+        int max = (size - (int)sizeof(telem_header_t)) / (int)sizeof(telem_wire_t);
+        return max > 0xffff ? 0xffff : max;
+    }
+
+    /**
+     * @brief Pack up to `count` samples into a TRACKING_DATA payload.
+     *
+     * @return int Payload size in bytes, -1 if `size` cannot hold the header and one sample.
+     * Samples beyond BatchMax(size) are left out.
+     */
+    static int Pack(const telem_sample_t *samples, int count, uint32_t dropped, unsigned char *buf, int size)
+    {
+        int max = BatchMax(size);
+        if (max <= 0)
+            return -1;
+        if (count > max)
+            count = max;
+        telem_header_t hdr;
+        hdr.version = TELEM_VERSION;
+        hdr.sample_size = sizeof(telem_wire_t);
+        hdr.count = count;
+        hdr.dropped = dropped;
+        hdr.t0_us = count > 0 ? samples[0].time_us : 0;
+        memcpy(buf, &hdr, sizeof(hdr));
+        unsigned char *p = buf + sizeof(hdr);
+        for (int i = 0; i < count; i++, p += sizeof(telem_wire_t))
+        {
+            const telem_sample_t &s = samples[i];
+            telem_wire_t w;
+            w.dt_us = s.time_us - hdr.t0_us;
+            w.target = s.target;
+            w.cmd_az = s.cmd_az;
+            w.cmd_el = s.cmd_el;
+            w.pred_az = s.pred_az;
+            w.pred_el = s.pred_el;
+            w.range_rate = s.range_rate;
+            w.latency_us = s.latency_us > 0xffff ? 0xffff : s.latency_us;
+            w.flags = s.flags;
+            w.range = s.range;
+            w.dl_doppler = s.dl_doppler;
+            w.ul_doppler = s.ul_doppler;
+            memcpy(p, &w, sizeof(w));
+        }
+        return p - buf;
+    }
+};
+
+#endif // TELEMETRY_HPP
@@ -0,0 +1,288 @@
+/**
+ * @file TickScheduler.hpp
+ * @brief Built-in tracking tick: a dedicated thread woken on absolute deadlines, optionally
+ * SCHED_FIFO and pinned to a CPU.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * Deadlines are start + n * period on CLOCK_MONOTONIC, so the tick does not drift however long
+ * the handler runs. A handler that runs past one or more deadlines does not get called back to
+ * back to catch up: the missed deadlines are counted and the next wake-up is the first deadline
+ * still ahead, keeping the phase. Wake-up lateness is recorded as INSTR_TICK_JITTER.
+ *
+ * In adaptive mode the period is not fixed: after every tick the interval function says how long
+ * to wait for the next one, between 1 / TICK_RATE_MAX and whatever it likes, e.g. until the next
+ * AOS. The next deadline is the last one plus that interval. Wake() cuts a wait short when the
+ * interval it was based on no longer holds.
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef TICK_SCHEDULER_HPP
+#define TICK_SCHEDULER_HPP
+
+#include <Instrument.hpp>
+#include <atomic>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <time.h>
+
+#define TICK_RATE_MIN 1      // Hz
+#define TICK_RATE_MAX 100    // Hz
+#define TICK_RT_PRIORITY 80  // SCHED_FIFO priority of the tick thread, above the I/O threads
+
+typedef void (*tick_handler_t)(void *ctx);
+typedef double (*tick_interval_t)(void *ctx); // seconds until the next tick
+
+typedef struct
+{
+    uint64_t ticks;   // handler calls
+    uint64_t missed;  // deadlines skipped because the handler was still running
+    uint64_t woken;   // adaptive waits cut short by Wake()
+    uint64_t fixed;   // ticks a fixed `rate` would have made over the same time
+    double cpu;       // seconds of CPU time spent in the tick thread
+    bool realtime;    // SCHED_FIFO was granted
+    bool pinned;      // running on the requested CPU
+} tick_stats_t;
+
+class TickScheduler
+{
+private:
+    pthread_t tid;
+    std::atomic<bool> running{false};
+    std::atomic<uint64_t> ticks{0};
+    std::atomic<uint64_t> missed{0};
+    std::atomic<uint64_t> woken{0};
+    std::atomic<uint64_t> cpu_ns{0};
+    std::atomic<bool> realtime{false};
+    std::atomic<bool> pinned{false};
+    uint64_t period_ns = 0;
+    uint64_t start_ns = 0;
+    int cpu = -1;
+    int priority = 0;
+    tick_handler_t handler = nullptr;
+    tick_interval_t interval = nullptr; // adaptive mode when set
+    void *ctx = nullptr;
+    pthread_mutex_t wake_lock = PTHREAD_MUTEX_INITIALIZER;
+    pthread_cond_t wake_cond;
+    bool wake = false;
+
+    static void to_timespec(uint64_t ns, struct timespec *ts)
+    {
+        ts->tv_sec = ns / 1000000000ULL;
+        ts->tv_nsec = ns % 1000000000ULL;
+    }
+
+    void setup()
+    {
+        if (cpu >= 0)
+        {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpu, &set);
+            pinned = pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+        }
+        if (priority > 0)
+        {
+            struct sched_param sp;
+            sp.sched_priority = priority;
+            realtime = pthread_setschedparam(pthread_self(), SCHED_FIFO, &sp) == 0; // EPERM without CAP_SYS_NICE
+        }
+    }
+
+    static uint64_t thread_cpu()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    }
+
+    /**
+     * @brief Sleep until `next` on CLOCK_MONOTONIC, or until Wake() in adaptive mode.
+     *
+     * @return uint64_t The deadline the tick is for: `next`, or the time of the wake-up.
+     */
+    uint64_t sleep(uint64_t next)
+    {
+        struct timespec ts;
+        to_timespec(next, &ts);
+        if (interval == nullptr)
+        {
+            while ((clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) && running)
+                ;
+            return next;
+        }
+        pthread_mutex_lock(&wake_lock);
+        while (!wake && running && (pthread_cond_timedwait(&wake_cond, &wake_lock, &ts) != ETIMEDOUT))
+            ;
+        bool woke = wake;
+        wake = false;
+        pthread_mutex_unlock(&wake_lock);
+        if (!woke)
+            return next;
+        woken.fetch_add(1, std::memory_order_relaxed);
+        uint64_t now = instr_now();
+        return now < next ? now : next;
+    }
+
+    static void *thread(void *p)
+    {
+        TickScheduler *s = (TickScheduler *)p;
+        s->setup();
+        uint64_t cpu0 = thread_cpu();
+        uint64_t next = instr_now() + s->period_ns;
+        while (s->running)
+        {
+            next = s->sleep(next);
+            if (!s->running)
+                break;
+            uint64_t now = instr_now();
+            instruments().Record(INSTR_TICK_JITTER, now > next ? now - next : 0);
+            s->handler(s->ctx);
+            s->ticks.fetch_add(1, std::memory_order_relaxed);
+            uint64_t period = s->period_ns;
+            if (s->interval != nullptr)
+            {
+                double sec = s->interval(s->ctx);
+                period = sec < 1.0 / TICK_RATE_MAX ? 1e9 / TICK_RATE_MAX : sec * 1e9;
+            }
+            next += period;
+            now = instr_now();
+            if (now >= next)
+            {
+                uint64_t skip = (now - next) / period + 1;
+                s->missed.fetch_add(skip, std::memory_order_relaxed);
+                next += skip * period;
+            }
+            s->cpu_ns.store(thread_cpu() - cpu0, std::memory_order_relaxed);
+        }
+        return NULL;
+    }
+
+    int start(double rate, tick_handler_t fn, tick_interval_t next, void *ctx, int cpu, int priority)
+    {
+        if ((rate < TICK_RATE_MIN) || (rate > TICK_RATE_MAX) || (fn == nullptr))
+            return -1;
+        if (running)
+            return -2;
+        period_ns = 1e9 / rate;
+        this->cpu = cpu;
+        this->priority = priority;
+        handler = fn;
+        interval = next;
+        this->ctx = ctx;
+        ticks = 0;
+        missed = 0;
+        woken = 0;
+        cpu_ns = 0;
+        realtime = false;
+        pinned = false;
+        wake = false;
+        start_ns = instr_now();
+        running = true;
+        if (pthread_create(&tid, NULL, thread, this) != 0)
+        {
+            running = false;
+            return -3;
+        }
+        return 1;
+    }
+
+public:
+    TickScheduler()
+    {
+        pthread_condattr_t attr;
+        pthread_condattr_init(&attr);
+        pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+        pthread_cond_init(&wake_cond, &attr);
+        pthread_condattr_destroy(&attr);
+    }
+
+    ~TickScheduler()
+    {
+        Stop();
+        pthread_cond_destroy(&wake_cond);
+    }
+
+    TickScheduler(const TickScheduler &) = delete;
+    TickScheduler &operator=(const TickScheduler &) = delete;
+
+    /**
+     * @brief Call `fn(ctx)` at `rate` Hz until Stop(). `cpu` < 0 leaves the thread unpinned,
+     * `priority` 0 leaves it at the default policy. Missing privileges for either are not an
+     * error, GetStats() tells what was granted.
+     *
+     * @return int 1 on success, -1 on a rate outside TICK_RATE_MIN..TICK_RATE_MAX, -2 if already
+     * running, -3 if the thread cannot be created.
+     */
+    int Start(double rate, tick_handler_t fn, void *ctx, int cpu = -1, int priority = TICK_RT_PRIORITY)
+    {
+        return start(rate, fn, nullptr, ctx, cpu, priority);
+    }
+
+    /**
+     * @brief As Start(), with the wait after each tick taken from `next(ctx)`. `rate` is the
+     * first period, and the fixed rate GetStats() compares against.
+     *
+     */
+    int StartAdaptive(double rate, tick_handler_t fn, tick_interval_t next, void *ctx, int cpu = -1, int priority = TICK_RT_PRIORITY)
+    {
+        if (next == nullptr)
+            return -1;
+        return start(rate, fn, next, ctx, cpu, priority);
+    }
+
+    /**
+     * @brief Tick now instead of at the end of the current adaptive wait. Callable from any
+     * thread; no effect at a fixed rate.
+     *
+     */
+    void Wake()
+    {
+        pthread_mutex_lock(&wake_lock);
+        wake = true;
+        pthread_cond_signal(&wake_cond);
+        pthread_mutex_unlock(&wake_lock);
+    }
+
+    static void WakeHandler(void *ctx)
+    {
+        ((TickScheduler *)ctx)->Wake();
+    }
+
+    /**
+     * @brief Stop the thread. Returns once the handler is no longer running, within a period.
+     *
+     */
+    void Stop()
+    {
+        if (!running)
+            return;
+        running = false;
+        Wake();
+        pthread_join(tid, NULL);
+    }
+
+    bool IsRunning() const
+    {
+        return running;
+    }
+
+    tick_stats_t GetStats() const
+    {
+        tick_stats_t st;
+        st.ticks = ticks.load(std::memory_order_relaxed);
+        st.missed = missed.load(std::memory_order_relaxed);
+        st.woken = woken.load(std::memory_order_relaxed);
+        st.fixed = period_ns > 0 ? (instr_now() - start_ns) / period_ns : 0;
+        st.cpu = cpu_ns.load(std::memory_order_relaxed) * 1e-9;
+        st.realtime = realtime;
+        st.pinned = pinned;
+        return st;
+    }
+};
+
+#endif // TICK_SCHEDULER_HPP
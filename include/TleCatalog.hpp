@@ -0,0 +1,513 @@
+/**
+ * @file TleCatalog.hpp
+ * @brief Element catalog: bulk TLE ingestion, a memory-mappable binary store and O(1) lookup by
+ * NORAD ID.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * Only the newest epoch of each object is kept. Binary layout, native byte order:
+ *   tle_catalog_header_t
+ *   tle_record_t[count]        parsed elements and the element lines they came from
+ *   uint32_t[slots]            open addressing index by NORAD ID, TLE_CATALOG_EMPTY if unused
+ *
+ * The element lines stay in the record because libsgp4 only builds a propagator from text;
+ * BatchSGP4 takes the parsed elements directly.
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef TLE_CATALOG_HPP
+#define TLE_CATALOG_HPP
+
+#include <BatchSGP4.hpp>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+#define TLE_CATALOG_MAGIC 0x43454c54 // "TLEC"
+#define TLE_CATALOG_VERSION 1
+#define TLE_CATALOG_EMPTY 0xffffffff
+#define TLE_LINE_LEN 69
+
+typedef struct
+{
+    uint32_t magic;       // TLE_CATALOG_MAGIC
+    uint32_t version;     // TLE_CATALOG_VERSION
+    uint32_t record_size; // sizeof(tle_record_t) of the writer
+    uint32_t count;       // records
+    uint32_t slots;       // index entries, a power of two
+    uint32_t reserved;
+} tle_catalog_header_t;
+
+typedef struct
+{
+    tle_elements_t el;
+    char line1[TLE_LINE_LEN + 1];
+    char line2[TLE_LINE_LEN + 1];
+} tle_record_t;
+
+/**
+ * @brief What an ingestion did with the entries it read.
+ *
+ */
+typedef struct
+{
+    int added;    // new objects
+    int updated;  // newer epoch replaced the stored one
+    int stale;    // same or older epoch than the stored one
+    int rejected; // malformed or failed the checksum
+} tle_ingest_t;
+
+class TleCatalog
+{
+private:
+    // owned storage, used once the catalog is modified
+    std::vector<tle_record_t> records;
+    std::vector<uint32_t> index;
+    // what lookups read: the owned vectors or the mapped file
+    const tle_record_t *rec = nullptr;
+    const uint32_t *slot = nullptr;
+    uint32_t count = 0;
+    uint32_t slots = 0;
+    void *map = nullptr;
+    size_t map_size = 0;
+
+    static uint32_t hash(int id, uint32_t slots)
+    {
+        return ((uint32_t)id * 2654435761u) & (slots - 1);
+    }
+
+    static int digits(const char *p, int n)
+    {
+        int v = 0;
+        for (int i = 0; i < n; i++)
+        {
+            if (p[i] == ' ')
+                continue;
+            if ((p[i] < '0') || (p[i] > '9'))
+                return -1;
+            v = v * 10 + (p[i] - '0');
+        }
+        return v;
+    }
+
+    /**
+     * @brief Fixed-point field such as " 51.6441" or " .00001431", optionally signed.
+     *
+     */
+    static int decimal(const char *p, int n, double *out)
+    {
+        double v = 0, scale = 0;
+        bool neg = false, any = false;
+        for (int i = 0; i < n; i++)
+        {
+            char c = p[i];
+            if ((c == ' ') || (c == '+'))
+                continue;
+            if (c == '-')
+                neg = true;
+            else if (c == '.')
+                scale = 1;
+            else if ((c >= '0') && (c <= '9'))
+            {
+                v = v * 10 + (c - '0');
+                scale *= 10;
+                any = true;
+            }
+            else
+                return -1;
+        }
+        if (!any)
+            return -1;
+        *out = (neg ? -v : v) / (scale > 0 ? scale : 1);
+        return 1;
+    }
+
+    /**
+     * @brief Field with an assumed leading decimal point and an exponent, e.g. " 34209-4".
+     *
+     */
+    static int exponential(const char *p, double *out)
+    {
+        double mant;
+        if (decimal(p, 6, &mant) < 0)
+            return -1;
+        int exp = digits(p + 7, 1);
+        if ((exp < 0) || ((p[6] != '-') && (p[6] != '+') && (p[6] != ' ')))
+            return -1;
+        *out = mant * 1e-5 * pow(10.0, p[6] == '-' ? -exp : exp);
+        return 1;
+    }
+
+    /**
+     * @brief Copy the mapped file into owned storage, so it can be modified.
+     *
+     */
+    void own()
+    {
+        if (map == nullptr)
+            return;
+        records.assign(rec, rec + count);
+        index.assign(slot, slot + slots);
+        munmap(map, map_size);
+        map = nullptr;
+        map_size = 0;
+        rec = records.data();
+        slot = index.data();
+    }
+
+    void rehash(uint32_t want)
+    {
+        uint32_t n = 16;
+        while (n < want * 2)
+            n <<= 1;
+        index.assign(n, TLE_CATALOG_EMPTY);
+        for (uint32_t i = 0; i < records.size(); i++)
+        {
+            uint32_t h = hash(records[i].el.id, n);
+            while (index[h] != TLE_CATALOG_EMPTY)
+                h = (h + 1) & (n - 1);
+            index[h] = i;
+        }
+        slots = n;
+        slot = index.data();
+    }
+
+    void close_map()
+    {
+        if (map != nullptr)
+            munmap(map, map_size);
+        map = nullptr;
+        map_size = 0;
+    }
+
+public:
+    TleCatalog() {}
+
+    ~TleCatalog()
+    {
+        close_map();
+    }
+
+    TleCatalog(const TleCatalog &) = delete;
+    TleCatalog &operator=(const TleCatalog &) = delete;
+
+    /**
+     * @brief TLE checksum of the first 68 columns: digits, plus one for every minus sign.
+     *
+     */
+    static int Checksum(const char *line)
+    {
+        int sum = 0;
+        for (int i = 0; i < TLE_LINE_LEN - 1; i++)
+        {
+            if ((line[i] >= '0') && (line[i] <= '9'))
+                sum += line[i] - '0';
+            else if (line[i] == '-')
+                sum++;
+        }
+        return sum % 10;
+    }
+
+    /**
+     * @brief Parse one pair of element lines without libsgp4. Lines may be longer than 69
+     * characters (trailing whitespace or line endings are ignored).
+     *
+     * @return int 1 on success, -1 on a malformed line, -2 on a checksum mismatch.
+     */
+    static int Parse(const char *l1, const char *l2, tle_elements_t *out)
+    {
+        for (int i = 0; i < TLE_LINE_LEN; i++)
+            if ((l1[i] == '\0') || (l2[i] == '\0'))
+                return -1;
+        if ((l1[0] != '1') || (l2[0] != '2') || (l1[1] != ' ') || (l2[1] != ' '))
+            return -1;
+        if ((Checksum(l1) != l1[68] - '0') || (Checksum(l2) != l2[68] - '0'))
+            return -2;
+        int id = digits(l1 + 2, 5);
+        if ((id <= 0) || (id != digits(l2 + 2, 5)))
+            return -1;
+        int year = digits(l1 + 18, 2);
+        double doy;
+        if ((year < 0) || (decimal(l1 + 20, 12, &doy) < 0))
+            return -1;
+        year += year < 57 ? 2000 : 1900;
+        double incl, raan, ecc, argp, ma, mm, bstar;
+        if ((decimal(l2 + 8, 8, &incl) < 0) || (decimal(l2 + 17, 8, &raan) < 0) || (decimal(l2 + 34, 8, &argp) < 0) || (decimal(l2 + 43, 8, &ma) < 0) || (decimal(l2 + 52, 11, &mm) < 0))
+            return -1;
+        int e = digits(l2 + 26, 7);
+        if ((e < 0) || (exponential(l1 + 53, &bstar) < 0))
+            return -1;
+        ecc = e * 1e-7;
+        // days from 0001-01-01 to January 1st of the epoch year, proleptic Gregorian
+        int64_t y = year - 1;
+        int64_t days = y * 365 + y / 4 - y / 100 + y / 400;
+        out->id = id;
+        out->epoch = days * 86400000000LL + llround((doy - 1) * 86400e6);
+        out->inclination = incl * M_PI / 180;
+        out->raan = raan * M_PI / 180;
+        out->eccentricity = ecc;
+        out->arg_perigee = argp * M_PI / 180;
+        out->mean_anomaly = ma * M_PI / 180;
+        out->mean_motion = mm;
+        out->bstar = bstar;
+        return 1;
+    }
+
+    /**
+     * @brief Map a catalog written by Save(). Lookups read the file directly.
+     *
+     * @return int Number of objects, -1 if the file cannot be read, -2 if it is not a catalog
+     * of this version, its index is corrupt or an element line is not terminated.
+     */
+    int Open(const char *path)
+    {
+        Clear();
+        int fd = open(path, O_RDONLY);
+        if (fd < 0)
+            return -1;
+        struct stat sb;
+        if ((fstat(fd, &sb) < 0) || ((size_t)sb.st_size < sizeof(tle_catalog_header_t)))
+        {
+            close(fd);
+            return -1;
+        }
+        void *p = mmap(NULL, sb.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (p == MAP_FAILED)
+            return -1;
+        const tle_catalog_header_t *hdr = (const tle_catalog_header_t *)p;
+        size_t need = sizeof(tle_catalog_header_t) + (size_t)hdr->count * sizeof(tle_record_t) + (size_t)hdr->slots * sizeof(uint32_t);
+        if ((hdr->magic != TLE_CATALOG_MAGIC) || (hdr->version != TLE_CATALOG_VERSION) || (hdr->record_size != sizeof(tle_record_t)) || (hdr->slots == 0) || ((hdr->slots & (hdr->slots - 1)) != 0) || (hdr->count >= hdr->slots) || ((size_t)sb.st_size < need))
+        {
+            munmap(p, sb.st_size);
+            return -2;
+        }
+        // element lines are copied out as strings, they have to end inside the record
+        const tle_record_t *r = (const tle_record_t *)((const char *)p + sizeof(tle_catalog_header_t));
+        bool ok = true;
+        for (uint32_t i = 0; ok && (i < hdr->count); i++)
+            ok = (memchr(r[i].line1, '\0', sizeof(r[i].line1)) != NULL) && (memchr(r[i].line2, '\0', sizeof(r[i].line2)) != NULL);
+        // Find() trusts the index: every entry has to name a record, and a probe has to end
+        const uint32_t *idx = (const uint32_t *)(r + hdr->count);
+        bool empty = false;
+        for (uint32_t i = 0; i < hdr->slots; i++)
+        {
+            if (idx[i] == TLE_CATALOG_EMPTY)
+                empty = true;
+            else if (idx[i] >= hdr->count)
+            {
+                empty = false;
+                break;
+            }
+        }
+        if (!ok || !empty)
+        {
+            munmap(p, sb.st_size);
+            return -2;
+        }
+        map = p;
+        map_size = sb.st_size;
+        count = hdr->count;
+        slots = hdr->slots;
+        rec = (const tle_record_t *)((const char *)p + sizeof(tle_catalog_header_t));
+        slot = (const uint32_t *)((const char *)rec + count * sizeof(tle_record_t));
+        return count;
+    }
+
+    /**
+     * @brief Write the catalog to `path`, replacing it atomically so readers that have the old
+     * file mapped keep a consistent view.
+     *
+     * @return int 1 on success, -1 on error.
+     */
+    int Save(const char *path) const
+    {
+        char tmp[4096];
+        if (snprintf(tmp, sizeof(tmp), "%s.tmp", path) >= (int)sizeof(tmp))
+            return -1;
+        FILE *fp = fopen(tmp, "wb");
+        if (fp == NULL)
+            return -1;
+        tle_catalog_header_t hdr;
+        memset(&hdr, 0x0, sizeof(hdr));
+        hdr.magic = TLE_CATALOG_MAGIC;
+        hdr.version = TLE_CATALOG_VERSION;
+        hdr.record_size = sizeof(tle_record_t);
+        hdr.count = count;
+        hdr.slots = slots;
+        bool ok = fwrite(&hdr, sizeof(hdr), 1, fp) == 1;
+        ok = ok && (fwrite(rec, sizeof(tle_record_t), count, fp) == count);
+        ok = ok && (fwrite(slot, sizeof(uint32_t), slots, fp) == slots);
+        ok = (fclose(fp) == 0) && ok;
+        if (!ok || (rename(tmp, path) < 0))
+        {
+            unlink(tmp);
+            return -1;
+        }
+        return 1;
+    }
+
+    /**
+     * @brief Add one object, or replace it if `l1`, `l2` have a newer epoch.
+     *
+     * @return int 1 if added, 2 if updated, 0 if stale, negative as Parse().
+     */
+    int Ingest(const char *l1, const char *l2)
+    {
+        tle_record_t r;
+        memset(&r, 0x0, sizeof(r));
+        int retval = Parse(l1, l2, &r.el);
+        if (retval < 0)
+            return retval;
+        memcpy(r.line1, l1, TLE_LINE_LEN);
+        memcpy(r.line2, l2, TLE_LINE_LEN);
+        own();
+        if (slots == 0)
+            rehash(16);
+        uint32_t h = hash(r.el.id, slots);
+        while (index[h] != TLE_CATALOG_EMPTY)
+        {
+            tle_record_t &old = records[index[h]];
+            if (old.el.id == r.el.id)
+            {
+                if (r.el.epoch <= old.el.epoch)
+                    return 0;
+                old = r;
+                return 2;
+            }
+            h = (h + 1) & (slots - 1);
+        }
+        index[h] = records.size();
+        records.push_back(r);
+        rec = records.data();
+        count = records.size();
+        if (count * 2 > slots)
+            rehash(count);
+        return 1;
+    }
+
+    /**
+     * @brief Ingest a text file of element sets, with or without name lines.
+     *
+     * @return int Number of element sets read, -1 if the file cannot be read.
+     */
+    int Ingest(const char *path, tle_ingest_t *result)
+    {
+        memset(result, 0x0, sizeof(tle_ingest_t));
+        int fd = open(path, O_RDONLY);
+        if (fd < 0)
+            return -1;
+        struct stat sb;
+        if (fstat(fd, &sb) < 0)
+        {
+            close(fd);
+            return -1;
+        }
+        if (sb.st_size == 0)
+        {
+            close(fd);
+            return 0;
+        }
+        const char *text = (const char *)mmap(NULL, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (text == MAP_FAILED)
+            return -1;
+        const char *end = text + sb.st_size;
+        // lines are copied, padded with NUL, so a short last line cannot run off the mapping
+        char l1[TLE_LINE_LEN + 1], l2[TLE_LINE_LEN + 1];
+        bool have_l1 = false; // the previous line was a line 1
+        int total = 0;
+        for (const char *p = text; p < end;)
+        {
+            const char *eol = (const char *)memchr(p, '\n', end - p);
+            if (eol == nullptr)
+                eol = end;
+            int len = eol - p;
+            if ((len > 0) && (p[len - 1] == '\r'))
+                len--;
+            if ((len > 0) && (p[0] == '2') && have_l1)
+            {
+                memset(l2, 0x0, sizeof(l2));
+                memcpy(l2, p, std::min(len, TLE_LINE_LEN));
+                int retval = Ingest(l1, l2);
+                total++;
+                if (retval == 1)
+                    result->added++;
+                else if (retval == 2)
+                    result->updated++;
+                else if (retval == 0)
+                    result->stale++;
+                else
+                    result->rejected++;
+                have_l1 = false;
+            }
+            else if ((len > 0) && (p[0] == '1'))
+            {
+                memset(l1, 0x0, sizeof(l1));
+                memcpy(l1, p, std::min(len, TLE_LINE_LEN));
+                have_l1 = true;
+            }
+            else
+                have_l1 = false;
+            p = eol + 1;
+        }
+        munmap((void *)text, sb.st_size);
+        return total;
+    }
+
+    /**
+     * @brief Elements of `id`, valid until the catalog is modified, reopened or destroyed.
+     *
+     * @return const tle_record_t* nullptr if the object is not in the catalog.
+     */
+    const tle_record_t *Find(int id) const
+    {
+        if (slots == 0)
+            return nullptr;
+        uint32_t h = hash(id, slots);
+        while (slot[h] != TLE_CATALOG_EMPTY)
+        {
+            if (rec[slot[h]].el.id == id)
+                return &rec[slot[h]];
+            h = (h + 1) & (slots - 1);
+        }
+        return nullptr;
+    }
+
+    const tle_record_t *At(size_t i) const
+    {
+        return i < count ? &rec[i] : nullptr;
+    }
+
+    size_t Size() const
+    {
+        return count;
+    }
+
+    bool IsMapped() const
+    {
+        return map != nullptr;
+    }
+
+    void Clear()
+    {
+        close_map();
+        records.clear();
+        index.clear();
+        rec = nullptr;
+        slot = nullptr;
+        count = 0;
+        slots = 0;
+    }
+};
+
+#endif // TLE_CATALOG_HPP
@@ -0,0 +1,67 @@
+/**
+ * @file TrackClock.hpp
+ * @brief Time source of the tracker: the system clock, or a virtual clock for simulation and replay.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#ifndef TRACK_CLOCK_HPP
+#define TRACK_CLOCK_HPP
+
+#include <SGP4/DateTime.h>
+#include <atomic>
+#include <stdint.h>
+
+class TrackClock
+{
+public:
+    virtual ~TrackClock() {}
+
+    /**
+     * @brief Current UTC time as the tracker should see it.
+     *
+     */
+    virtual DateTime Now() = 0;
+};
+
+class WallClock : public TrackClock
+{
+public:
+    DateTime Now()
+    {
+        return DateTime::Now(true);
+    }
+};
+
+/**
+ * @brief Clock that only moves when told to. Readable from any thread; one thread sets it.
+ *
+ */
+class VirtualClock : public TrackClock
+{
+private:
+    std::atomic<int64_t> ticks;
+
+public:
+    VirtualClock(const DateTime &start) : ticks(start.Ticks()) {}
+
+    DateTime Now()
+    {
+        return DateTime(ticks.load(std::memory_order_acquire));
+    }
+
+    void Set(const DateTime &dt)
+    {
+        ticks.store(dt.Ticks(), std::memory_order_release);
+    }
+
+    void Advance(double seconds)
+    {
+        ticks.fetch_add((int64_t)(seconds * 1e6), std::memory_order_acq_rel);
+    }
+};
+
+#endif // TRACK_CLOCK_HPP
@@ -1,7 +1,8 @@
 /**
  * @file TrackingMotor.hpp
  * @author Sunip K. Mukherjee
- * @brief 
+ * @brief Rotator controller on a serial line: setpoints go out from an I/O thread, position
+ * reports come back on a reader thread.
  * @version See Git tags for version information.
  * @date 2021.08.16
  * 
@@ -17,15 +18,150 @@
 #include <termios.h>
 #include <unistd.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <time.h>
+#include <math.h>
+#include <algorithm>
+#include <Instrument.hpp>
+#include <RotatorProtocol.hpp>
+
+#define ROTATOR_AZ_RATE 6.0 // degrees/s
+#define ROTATOR_EL_RATE 1.5 // degrees/s
+#define ROTATOR_SETTLE 2.0  // seconds after a slew before the dish is on target
+#define ROTATOR_AZ_MIN 0    // degrees, mechanical stops of the azimuth axis
+#define ROTATOR_AZ_MAX 360  // degrees, 450 for rotators with an overlap region
+#define ROTATOR_EL_MAX 90   // degrees, 180 for rotators that can flip over the zenith
+
+#define MOTOR_CMD_SPACING 0.1   // seconds, the controller drops commands arriving faster than this
+#define MOTOR_WRITE_TIMEOUT 500 // ms to wait for the serial line to drain before giving up on a command
+#define MOTOR_BAUD 2400
+#define MOTOR_POLL_PERIOD 0.5   // seconds between position queries while no command goes out
+#define MOTOR_REPLY_TIMEOUT 1.0 // seconds before an unanswered query counts as missed
+#define MOTOR_FEEDBACK_AGE 2.0  // seconds a position report is trusted
+#define MOTOR_TOLERANCE 1       // degrees between report and setpoint that count as on target
+#define MOTOR_QUERIES 8         // queries awaiting a reply
+#define MOTOR_RX_POLL 100       // ms the reader waits for input before checking for shutdown
+
+/**
+ * @brief Mechanical limits of the rotator, used to plan moves between targets.
+ *
+ */
+typedef struct
+{
+    double az_rate; // degrees/s
+    double el_rate; // degrees/s
+    double settle;  // seconds
+} rotator_limits_t;
+
+/**
+ * @brief Travel of the rotator axes. Azimuth may cover more than a full turn; an elevation past
+ * 90 degrees points over the zenith, at azimuth + 180 in the sky.
+ *
+ */
+typedef struct
+{
+    double az_min; // degrees
+    double az_max; // degrees
+    double el_max; // degrees
+} rotator_range_t;
+
+/**
+ * @brief Angle in the sky between two rotator positions, in degrees.
+ *
+ */
+static inline double rotator_distance(double az0, double el0, double az1, double el1)
+{
+    if (el0 > 90) // flipped over
+    {
+        az0 += 180;
+        el0 = 180 - el0;
+    }
+    if (el1 > 90)
+    {
+        az1 += 180;
+        el1 = 180 - el1;
+    }
+    double daz = fmod(fabs(az1 - az0), 360);
+    if (daz > 180)
+        daz = 360 - daz;
+    daz *= cos((el0 + el1) / 2 * M_PI / 180);
+    return hypot(daz, el1 - el0);
+}
+
+typedef struct
+{
+    int mask; // MOTOR_AXIS_AZ | MOTOR_AXIS_EL, 0 if nothing is pending
+    int az;   // degrees
+    int el;   // degrees
+} motor_cmd_t;
+
+typedef struct
+{
+    int sent;    // writes to the port, commands and queries
+    int errors;  // writes that failed
+    int skipped; // setpoints already commanded and reached
+    int resent;  // setpoints repeated because the rotator stopped short of them
+    int reports; // position reports received
+    int missed;  // queries never answered
+} motor_stats_t;
 
 class TrackingMotor
 {
 private:
     bool ready;
     int fd;
-    int az, el;
+    int az, el; // last commanded, not necessarily sent yet
+    int baud;
+    RotatorProtocol proto;
+    motor_stats_t stats;
+
+    // setpoint waiting for the I/O thread, newer commands replace it until it is sent
+    motor_cmd_t pending;
+    bool io_active;
+    bool rx_active;
+    pthread_t io_tid;
+    pthread_t rx_tid;
+    pthread_mutex_t io_lock;
+    pthread_cond_t io_cond;
+    uint64_t last_sent; // instr_now() of the last write
+
+    // position reports
+    int meas_az, meas_el;
+    uint64_t meas_time;              // instr_now() of the last report, 0 if none
+    uint64_t meas_moved;             // instr_now() the reported position last changed
+    uint64_t queries[MOTOR_QUERIES]; // instr_now() of queries awaiting a reply, oldest first
+    int nqueries;
+
+    static speed_t speed(int baud)
+    {
+        switch (baud)
+        {
+        case 1200:
+            return B1200;
+        case 2400:
+            return B2400;
+        case 4800:
+            return B4800;
+        case 9600:
+            return B9600;
+        case 19200:
+            return B19200;
+        case 38400:
+            return B38400;
+        case 57600:
+            return B57600;
+        case 115200:
+            return B115200;
+        default:
+            return B0;
+        }
+    }
+
     int open_conn(const char *name)
     {
         ready = false;
@@ -42,36 +178,294 @@ private:
 
         struct termios options[1];
         tcgetattr(conn, options);
-        options->c_cflag = B2400 | CS8 | CLOCAL | CREAD;
+        options->c_cflag = speed(baud) | CS8 | CLOCAL | CREAD;
         options->c_iflag = IGNPAR;
         options->c_oflag = 0;
         options->c_lflag = 0;
+        cfsetispeed(options, speed(baud));
+        cfsetospeed(options, speed(baud));
         tcflush(conn, TCIFLUSH);
         tcsetattr(conn, TCSANOW, options);
 
         return conn;
     }
 
-public:
-    TrackingMotor()
+    void init()
     {
         fd = -1;
         ready = false;
+        az = 0;
+        el = 90;
+        baud = MOTOR_BAUD;
+        memset(&stats, 0x0, sizeof(stats));
+        memset(&pending, 0x0, sizeof(pending));
+        io_active = false;
+        rx_active = false;
+        last_sent = 0;
+        meas_az = meas_el = 0;
+        meas_time = meas_moved = 0;
+        nqueries = 0;
+        pthread_mutex_init(&io_lock, NULL);
+        pthread_condattr_t attr;
+        pthread_condattr_init(&attr);
+        pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+        pthread_cond_init(&io_cond, &attr);
+        pthread_condattr_destroy(&attr);
+    }
+
+    /**
+     * @brief Write a whole buffer to the (non-blocking) serial port.
+     *
+     * @return int 1 on success, negative on error.
+     */
+    int send(const char *buf, int sz)
+    {
+        int off = 0;
+        while (off < sz)
+        {
+            int retval = write(fd, buf + off, sz - off);
+            if (retval > 0)
+            {
+                off += retval;
+                continue;
+            }
+            if ((retval < 0) && (errno != EAGAIN) && (errno != EINTR))
+                return -1;
+            struct pollfd pfd = {fd, POLLOUT, 0};
+            if (poll(&pfd, 1, MOTOR_WRITE_TIMEOUT) <= 0)
+                return -2;
+        }
+        return 1;
+    }
+
+    /**
+     * @brief Drop queries that will not be answered any more. Called with io_lock held.
+     *
+     */
+    void expire(uint64_t now)
+    {
+        int n = 0;
+        while ((n < nqueries) && (now - queries[n] > MOTOR_REPLY_TIMEOUT * 1e9))
+            n++;
+        stats.missed += n;
+        nqueries -= n;
+        memmove(queries, queries + n, nqueries * sizeof(uint64_t));
+    }
+
+    /**
+     * @brief Whether the rotator has come to rest away from the setpoint. Called with io_lock held.
+     *
+     */
+    bool stalled(uint64_t now)
+    {
+        if ((meas_time == 0) || (now - meas_time > MOTOR_FEEDBACK_AGE * 1e9) || (pending.mask != 0))
+            return false;
+        if (now - meas_moved < ROTATOR_SETTLE * 1e9)
+            return false;
+        int daz = abs(meas_az - az) % 360;
+        return (std::min(daz, 360 - daz) > MOTOR_TOLERANCE) || (abs(meas_el - el) > MOTOR_TOLERANCE);
+    }
+
+    void report(int az, int el)
+    {
+        uint64_t now = instr_now();
+        pthread_mutex_lock(&io_lock);
+        expire(now);
+        if (nqueries > 0) // replies come back in order
+        {
+            instruments().Record(INSTR_MOTOR_RTT, now - queries[0]);
+            nqueries--;
+            memmove(queries, queries + 1, nqueries * sizeof(uint64_t));
+        }
+        if ((meas_time == 0) || (az != meas_az) || (el != meas_el))
+            meas_moved = now;
+        meas_az = az;
+        meas_el = el;
+        meas_time = now;
+        stats.reports++;
+        pthread_mutex_unlock(&io_lock);
+    }
+
+    /**
+     * @brief Sends the pending setpoint no faster than MOTOR_CMD_SPACING, both axes in one write.
+     * Commands that arrive while it waits replace the pending one, so only the latest setpoint
+     * goes out. When the controller reports its position, a query follows every command and is
+     * sent on its own every MOTOR_POLL_PERIOD. Whatever is pending is flushed before the thread
+     * exits.
+     *
+     */
+    static void *IOThread(void *p)
+    {
+        TrackingMotor *mot = (TrackingMotor *)p;
+        char buf[ROTATOR_LINE_MAX];
+        pthread_mutex_lock(&mot->io_lock);
+        while (mot->io_active || (mot->pending.mask != 0))
+        {
+            bool cmd = mot->pending.mask != 0;
+            if (!cmd && !(mot->io_active && mot->proto.HasFeedback()))
+            {
+                pthread_cond_wait(&mot->io_cond, &mot->io_lock);
+                continue;
+            }
+            uint64_t now = instr_now();
+            uint64_t next = mot->last_sent + (cmd ? MOTOR_CMD_SPACING : MOTOR_POLL_PERIOD) * 1e9;
+            if (now < next)
+            {
+                struct timespec ts;
+                ts.tv_sec = next / 1000000000ULL;
+                ts.tv_nsec = next % 1000000000ULL;
+                pthread_cond_timedwait(&mot->io_cond, &mot->io_lock, &ts);
+                continue;
+            }
+            int sz;
+            if (cmd)
+                sz = mot->proto.Command(buf, sizeof(buf), mot->pending.mask, mot->pending.az, mot->pending.el);
+            else // nothing to send, ask where the rotator is
+                sz = mot->proto.Query(buf, sizeof(buf));
+            mot->pending.mask = 0;
+            pthread_mutex_unlock(&mot->io_lock);
+
+            uint64_t start = instr_now();
+            int retval = sz > 0 ? mot->send(buf, sz) : -1;
+            if (cmd)
+                instruments().Since(INSTR_SERIAL_WRITE, start);
+
+            pthread_mutex_lock(&mot->io_lock);
+            mot->last_sent = instr_now();
+            mot->stats.sent++;
+            if (retval < 0)
+                mot->stats.errors++;
+            else if (mot->proto.HasFeedback())
+            {
+                mot->expire(start);
+                if (mot->nqueries == MOTOR_QUERIES) // controller stopped answering
+                {
+                    mot->stats.missed++;
+                    memmove(mot->queries, mot->queries + 1, --mot->nqueries * sizeof(uint64_t));
+                }
+                mot->queries[mot->nqueries++] = start;
+            }
+        }
+        pthread_mutex_unlock(&mot->io_lock);
+        return NULL;
+    }
+
+    /**
+     * @brief Reads position reports, when the controller sends them.
+     *
+     */
+    static void *RxThread(void *p)
+    {
+        TrackingMotor *mot = (TrackingMotor *)p;
+        char buf[ROTATOR_LINE_MAX];
+        mot->proto.Reset();
+        while (mot->rx_active)
+        {
+            struct pollfd pfd = {mot->fd, POLLIN, 0};
+            if (poll(&pfd, 1, MOTOR_RX_POLL) <= 0)
+                continue;
+            int n = read(mot->fd, buf, sizeof(buf));
+            if (n <= 0)
+            {
+                if ((n == 0) || ((errno != EAGAIN) && (errno != EINTR))) // hung up, keep polling slowly
+                    usleep(MOTOR_RX_POLL * 1000);
+                continue;
+            }
+            int az, el;
+            for (int i = 0; i < n; i++)
+                if (mot->proto.Parse(buf[i], &az, &el) > 0)
+                    mot->report(az, el);
+        }
+        return NULL;
+    }
+
+    int start()
+    {
+        io_active = true;
+        if (pthread_create(&io_tid, NULL, IOThread, this) != 0)
+        {
+            io_active = false;
+            return -1;
+        }
+        if (!proto.HasFeedback())
+            return 1;
+        rx_active = true;
+        if (pthread_create(&rx_tid, NULL, RxThread, this) != 0)
+        {
+            rx_active = false;
+            stop();
+            return -1;
+        }
+        return 1;
+    }
+
+    void stop()
+    {
+        if (io_active)
+        {
+            pthread_mutex_lock(&io_lock);
+            io_active = false;
+            pthread_cond_signal(&io_cond);
+            pthread_mutex_unlock(&io_lock);
+            pthread_join(io_tid, NULL);
+        }
+        if (rx_active)
+        {
+            rx_active = false;
+            pthread_join(rx_tid, NULL);
+        }
+    }
+
+    /**
+     * @brief Make `mask` part of the pending setpoint and record it as commanded.
+     *
+     */
+    void enqueue(int mask, int az, int el)
+    {
+        pthread_mutex_lock(&io_lock);
+        this->az = az;
+        this->el = el;
+        pending.mask |= mask;
+        pending.az = az;
+        pending.el = el;
+        pthread_cond_signal(&io_cond);
+        pthread_mutex_unlock(&io_lock);
+    }
+
+public:
+    TrackingMotor()
+    {
+        init();
     }
 
     TrackingMotor(const char *name)
     {
+        init();
         if (name == NULL)
             return;
-        fd = open_conn(name);
-        if (fd >= 3)
-            ready = true;
-        az = 0;
-        el = 90;
+        if (Open(name) < 0)
+            return;
         SetAz(az);
         SetEl(el);
     }
 
+    TrackingMotor(const TrackingMotor &) = delete;
+    TrackingMotor &operator=(const TrackingMotor &) = delete;
+
+    /**
+     * @brief Line speed and controller dialect (motor_proto_t) used by the next Open().
+     *
+     * @return int 1 on success, -1 if either is not supported.
+     */
+    int Configure(int baud, int proto)
+    {
+        if ((speed(baud) == B0) || (proto < MOTOR_PROTO_PAPB) || (proto > MOTOR_PROTO_GS232))
+            return -1;
+        this->baud = baud;
+        this->proto = RotatorProtocol(proto);
+        return 1;
+    }
+
     int Open()
     {
         return Open("/dev/ttyUSB0");
@@ -81,9 +475,21 @@ public:
     {
         if (name == NULL)
             return -1;
-        fd = open_conn(name);
+        stop();
         if (fd >= 3)
-            ready = true;
+            close(fd);
+        fd = open_conn(name);
+        if (fd < 3)
+            return fd;
+        meas_time = 0;
+        nqueries = 0;
+        if (start() < 0)
+        {
+            close(fd);
+            fd = -1;
+            return -1;
+        }
+        ready = true;
         // az = 0;
         // el = 90;
         // SetAz(az);
@@ -91,27 +497,21 @@ public:
         return fd;
     }
 
+    /**
+     * @brief Command an azimuth. Returns immediately, the I/O thread sends it.
+     *
+     * @return int The azimuth on success, -1 if out of range, -3 if the port is not open.
+     */
     int SetAz(int az)
     {
-        static char buf[8];
-        if (az < 0)
+        if (az < ROTATOR_AZ_MIN)
             return -1;
-        if (az > 360)
+        if (az > ROTATOR_AZ_MAX)
             return -1;
         if (ready)
         {
-            int sz = snprintf(buf, sizeof(buf), "PB %d\r", az);
-            int retval = write(fd, buf, sz);
-            if (sz == retval)
-            {
-                this->az = az;
-                usleep(0.1 * 1000000);
-                return az;
-            }
-            else
-            {
-                return -2;
-            }    
+            enqueue(MOTOR_AXIS_AZ, az, this->el);
+            return az;
         }
         return -3;
     }
@@ -121,27 +521,21 @@ public:
         return this->az;
     }
 
+    /**
+     * @brief Command an elevation. Returns immediately, the I/O thread sends it.
+     *
+     * @return int The elevation on success, -1 if out of range, -3 if the port is not open.
+     */
     int SetEl(int el)
     {
-        static char buf[8];
         if (el < 0)
             return -1;
-        if (el > 90)
+        if (el > ROTATOR_EL_MAX)
             return -1;
         if (ready)
         {
-            int sz = snprintf(buf, sizeof(buf), "PA %d\r", el);
-            int retval = write(fd, buf, sz);
-            if (sz == retval)
-            {
-                this->el = el;
-                usleep(0.1 * 1000000);
-                return el;
-            }
-            else
-            {
-                return -2;
-            }    
+            enqueue(MOTOR_AXIS_EL, this->az, el);
+            return el;
         }
         return -3;
     }
@@ -151,6 +545,78 @@ public:
         return this->el;
     }
 
+    /**
+     * @brief Command both axes, in one write. A setpoint equal to the last one is skipped, unless
+     * position reports show the rotator came to rest short of it; then it is sent again.
+     *
+     * @return int 1 if sent, 0 if skipped, -1 if out of range, -3 if the port is not open.
+     */
+    int SetPosition(int az, int el)
+    {
+        if ((az < ROTATOR_AZ_MIN) || (az > ROTATOR_AZ_MAX) || (el < 0) || (el > ROTATOR_EL_MAX))
+            return -1;
+        if (!ready)
+            return -3;
+        int mask = (az != this->az ? MOTOR_AXIS_AZ : 0) | (el != this->el ? MOTOR_AXIS_EL : 0);
+        pthread_mutex_lock(&io_lock);
+        if ((mask == 0) && stalled(instr_now()))
+        {
+            mask = MOTOR_AXIS_AZ | MOTOR_AXIS_EL;
+            stats.resent++;
+        }
+        else if (mask == 0)
+            stats.skipped++;
+        pthread_mutex_unlock(&io_lock);
+        if (mask == 0)
+            return 0;
+        enqueue(mask, az, el);
+        return 1;
+    }
+
+    /**
+     * @brief Last position reported by the controller, in degrees, and its age in seconds.
+     *
+     * @return int 1 on success, 0 if there is no recent report, -1 if the controller does not
+     * report its position.
+     */
+    int GetPosition(double *az, double *el, double *age)
+    {
+        if (!proto.HasFeedback())
+            return -1;
+        uint64_t now = instr_now();
+        int retval = 0;
+        pthread_mutex_lock(&io_lock);
+        if ((meas_time != 0) && (now - meas_time <= MOTOR_FEEDBACK_AGE * 1e9))
+        {
+            *az = meas_az;
+            *el = meas_el;
+            *age = (now - meas_time) * 1e-9;
+            retval = 1;
+        }
+        pthread_mutex_unlock(&io_lock);
+        return retval;
+    }
+
+    /**
+     * @brief Number of commands that could not be written to the port.
+     *
+     */
+    int GetErrors()
+    {
+        pthread_mutex_lock(&io_lock);
+        int retval = stats.errors;
+        pthread_mutex_unlock(&io_lock);
+        return retval;
+    }
+
+    motor_stats_t GetStats()
+    {
+        pthread_mutex_lock(&io_lock);
+        motor_stats_t retval = stats;
+        pthread_mutex_unlock(&io_lock);
+        return retval;
+    }
+
     bool IsReady()
     {
         return ready;
@@ -159,8 +625,11 @@ public:
     ~TrackingMotor()
     {
         ready = false;
+        stop(); // flushes whatever is still pending
         if (fd >= 3)
             close(fd);
+        pthread_cond_destroy(&io_cond);
+        pthread_mutex_destroy(&io_lock);
     }
 };
-#endif // TRACKING_MOTOR_HPP
\ No newline at end of file
+#endif // TRACKING_MOTOR_HPP
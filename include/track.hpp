@@ -15,33 +15,74 @@
 #define TRACK_HPP
 
 #define SEC *1000000
-#define CMD_UPDATE_TLE 1
+#define TRACK_TICK_RATE 10          // Hz, tracking ticks and telemetry samples
+#define TELEM_SEND_PERIOD 500       // ms between telemetry flushes
+#define TRACK_SCHEDULE_FILE "track_schedule.bin" // planner's work, to resume after a restart
+#define CMD_UPDATE_TLE 1      // add the target, or replace its elements; priority applies
+#define CMD_REMOVE_TARGET 2   // stop tracking target
+#define CMD_SET_PRIORITY 3    // change the priority of target
+#define CMD_TRACK_ID 4        // as CMD_UPDATE_TLE, with the elements of target from the catalog
 #define DEFAULT_TLE1 "1 25544U 98067A   21229.77243765  .00001431  00000-0  34209-4 0  9998"
 #define DEFAULT_TLE2 "2 25544  51.6441  38.1681 0001381 320.9423  62.5381 15.48912726298140"
 
+class TargetSystem;
+class SessionLog;
+class TleCatalog;
+class NetEngine;
+
 typedef struct
 {
     NetDataClient *netdata;
+    NetEngine *net;      // owns netdata's socket, sends on behalf of the other threads
+    TargetSystem *tsys;
+    SessionLog *session; // records commands for replay, may be NULL
+    TleCatalog *catalog; // elements for CMD_TRACK_ID, may be NULL
     char TLE1[100];
     char TLE2[100];
+    bool rx_verbose; // log every received frame
+    bool telem_active;
+    int telem_period; // ms between telemetry flushes
+    int telem_batch;  // most samples per TRACKING_DATA frame, capped by the frame size
 } global_data_t;
 
 typedef struct
 {
     int cmd;
-    char TLE1[64];
-    char TLE2[64];
+    char TLE1[70]; // 69 characters and the terminator
+    char TLE2[70];
+    int target;    // NORAD ID
+    int priority;  // higher wins when passes overlap
 } track_cmd_t;
 
-typedef struct
-{
-    int az;
-    int el;
-    double lat;
-    double lon;
-    double alt;
-} track_data_t;
-
-void *gs_network_rx_thread(void *args);
+/**
+ * @brief Handles one received frame. `payload` belongs to the receive thread and is overwritten
+ * by the next frame, copy anything that has to outlive the call.
+ *
+ * @return int 1 on success, negative on error.
+ */
+typedef int (*rx_handler_t)(global_data_t *global, NetType type, unsigned char *payload, int size);
+
+/**
+ * @brief Install the handler for one frame type, replacing the current one. nullptr drops
+ * frames of that type. Register before the receive thread starts.
+ *
+ * @return int 1 on success.
+ */
+int gs_rx_register(NetType type, rx_handler_t handler);
+
+/**
+ * @brief Dispatches one frame received by the network engine to its handler, `args` is the
+ * global_data_t.
+ *
+ */
+void gs_network_rx(void *args, NetFrame *netframe);
+
+/**
+ * @brief Drains the tracker's telemetry ring every telem_period ms into TRACKING_DATA frames of
+ * at most telem_batch samples (layout in Telemetry.hpp), and sends latency histograms as a
+ * STATUS frame every STATS_PERIOD (layout in Instrument.hpp). Runs while telem_active is set.
+ *
+ */
+void *gs_telemetry_thread(void *args);
 
 #endif // TRACK_HPP
\ No newline at end of file
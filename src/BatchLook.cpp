@@ -0,0 +1,139 @@
+/**
+ * @file BatchLook.cpp
+ * @brief Structure-of-arrays look angles, see BatchLook.hpp.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * Equations follow Observer::GetLookAngle and Eci(DateTime, CoordGeodetic) in libsgp4, with
+ * WGS-72 constants. The azimuth is the same quadrant-corrected atan, written as one atan2.
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include "BatchLook.hpp"
+
+// WGS-72, as in libsgp4
+static const double XKMPER = 6378.135;
+static const double F = 1.0 / 298.26;
+static const double OMEGA_E = 1.00273790934;
+static const double TWOPI = 2.0 * M_PI;
+static const int64_t TICKS_PER_DAY = 86400000000LL;
+
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__)
+#define BATCH_CLONES __attribute__((target_clones("avx2", "default")))
+#else
+#define BATCH_CLONES
+#endif
+
+void BatchLook::SetLocation(const CoordGeodetic &location)
+{
+    // geodetic to geocentric, the time-independent part of Eci(DateTime, CoordGeodetic)
+    st.lon = location.longitude;
+    st.sin_lat = sin(location.latitude);
+    st.cos_lat = cos(location.latitude);
+    const double c = 1.0 / sqrt(1.0 + F * (F - 2.0) * st.sin_lat * st.sin_lat);
+    const double s = (1.0 - F) * (1.0 - F) * c;
+    st.axial = (XKMPER * c + location.altitude) * st.cos_lat;
+    st.polar = (XKMPER * s + location.altitude) * st.sin_lat;
+}
+
+/**
+ * @brief DateTime::ToLocalMeanSiderealTime, rearranged to survive -ffast-math. Its 876600 h * t
+ * term is one turn per day since J2000 and the whole sum reaches ~1e5 rad, where any
+ * reordering loses ~1e-9 rad. Here the turns are dropped in integer ticks and only the slow
+ * terms are summed in floating point.
+ *
+ */
+static double sidereal(const DateTime &dt, double lon)
+{
+    // J2000 is noon, so the day fraction counts from noon
+    const int64_t ticks = dt.Ticks() + TICKS_PER_DAY / 2;
+    const double frac = (double)(ticks % TICKS_PER_DAY) / TICKS_PER_DAY;
+    const double t = ((double)ticks / TICKS_PER_DAY + 1721425.0 - 2451545.0) / 36525.0;
+    const double slow = 67310.54841 + t * (8640184.812866 + t * (0.093104 - t * 6.2e-6)); // arcseconds
+    const double theta = TWOPI * frac + slow * (M_PI / 180.0 / 240.0) + lon;
+    return theta - TWOPI * floor(theta / TWOPI);
+}
+
+/**
+ * @brief cos() through sin(), as in BatchSGP4.cpp, so the pair is not merged into sincos.
+ *
+ */
+static inline double vcos(double x)
+{
+    return sin(x + M_PI_2);
+}
+
+BATCH_CLONES static void kernel(const BatchLook::station_t &st, const batch_state_t &in, const double *__restrict theta, size_t lo, size_t hi, batch_look_t &out)
+{
+    const double *__restrict x = in.x.data();
+    const double *__restrict y = in.y.data();
+    const double *__restrict z = in.z.data();
+    const double *__restrict vx = in.vx.data();
+    const double *__restrict vy = in.vy.data();
+    const double *__restrict vz = in.vz.data();
+    double *__restrict oaz = out.az.data();
+    double *__restrict oel = out.el.data();
+    double *__restrict orange = out.range.data();
+    double *__restrict orate = out.range_rate.data();
+    const double mfactor = TWOPI * (OMEGA_E / 86400.0);
+    const double sl = st.sin_lat, cl = st.cos_lat;
+#pragma omp simd
+    for (size_t i = lo; i < hi; i++)
+    {
+        const double sth = sin(theta[i]), cth = vcos(theta[i]);
+
+        // station state in ECI, rotating with the earth
+        const double ox = st.axial * cth, oy = st.axial * sth;
+        const double rx = x[i] - ox, ry = y[i] - oy, rz = z[i] - st.polar;
+        const double rvx = vx[i] + mfactor * oy, rvy = vy[i] - mfactor * ox, rvz = vz[i];
+        const double range = sqrt(rx * rx + ry * ry + rz * rz);
+
+        // south, east, zenith
+        const double top_s = sl * cth * rx + sl * sth * ry - cl * rz;
+        const double top_e = -sth * rx + cth * ry;
+        const double top_z = cl * cth * rx + cl * sth * ry + sl * rz;
+        double az = atan2(top_e, -top_s);
+        az += az < 0.0 ? TWOPI : 0.0;
+        oaz[i] = az;
+        oel[i] = asin(top_z / range);
+        orange[i] = range;
+        orate[i] = (rx * rvx + ry * rvy + rz * rvz) / range;
+    }
+}
+
+void BatchLook::Kernel(const station_t &st, const batch_state_t &in, const double *theta, size_t lo, size_t hi, batch_look_t &out)
+{
+    kernel(st, in, theta, lo, hi, out);
+}
+
+static void resize(batch_look_t &out, size_t n)
+{
+    out.az.resize(n);
+    out.el.resize(n);
+    out.range.resize(n);
+    out.range_rate.resize(n);
+}
+
+int BatchLook::Compute(const batch_state_t &in, const DateTime &dt, batch_look_t &out) const
+{
+    size_t n = in.x.size();
+    resize(out, n);
+    std::vector<double> theta(n, sidereal(dt, st.lon));
+    Kernel(st, in, theta.data(), 0, n, out);
+    return n;
+}
+
+int BatchLook::Compute(const batch_state_t &in, const DateTime *times, batch_look_t &out) const
+{
+    size_t n = in.x.size();
+    resize(out, n);
+    std::vector<double> theta(n);
+    for (size_t i = 0; i < n; i++)
+        theta[i] = sidereal(times[i], st.lon);
+    Kernel(st, in, theta.data(), 0, n, out);
+    return n;
+}
@@ -0,0 +1,549 @@
+/**
+ * @file BatchSGP4.cpp
+ * @brief Structure-of-arrays SGP4 near-earth model, see BatchSGP4.hpp.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * Equations follow Spacetrack Report #3 as implemented by libsgp4, with WGS-72 constants.
+ * The lane loop has no data-dependent exits so it vectorizes; the Kepler solve always runs
+ * BATCH_SGP4_KEPLER_ITER iterations.
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <algorithm>
+#include <exception>
+#include "BatchSGP4.hpp"
+#include "meb_debug.h"
+
+// WGS-72, as in libsgp4
+static const double XKMPER = 6378.135;
+static const double XMU = 398600.8;
+static const double XKE = 60.0 / sqrt(XKMPER * XKMPER * XKMPER / XMU);
+static const double XJ2 = 1.082616e-3;
+static const double XJ3 = -2.53881e-6;
+static const double XJ4 = -1.65597e-6;
+static const double CK2 = 0.5 * XJ2;
+static const double CK4 = -0.375 * XJ4;
+static const double QOMS2T = pow((120.0 - 78.0) / XKMPER, 4.0);
+static const double S0 = 1.0 + 78.0 / XKMPER;
+static const double A3OVK2 = -XJ3 / CK2;
+static const double TWOPI = 2.0 * M_PI;
+static const double MINUTES_PER_DAY = 1440.0;
+
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__)
+#define BATCH_CLONES __attribute__((target_clones("avx2", "default")))
+#else
+#define BATCH_CLONES
+#endif
+
+BatchSGP4::~BatchSGP4()
+{
+    Clear();
+}
+
+void BatchSGP4::Clear()
+{
+    for (size_t i = 0; i < deep.size(); i++)
+        delete deep[i];
+    deep.clear();
+    ids.clear();
+    epochs.clear();
+    el = soa_t();
+}
+
+tle_elements_t BatchSGP4::Elements(const Tle &tle)
+{
+    tle_elements_t e;
+    e.id = tle.NoradNumber();
+    e.epoch = tle.Epoch().Ticks();
+    e.inclination = tle.Inclination(false);
+    e.raan = tle.RightAscendingNode(false);
+    e.eccentricity = tle.Eccentricity();
+    e.arg_perigee = tle.ArgumentPerigee(false);
+    e.mean_anomaly = tle.MeanAnomaly(false);
+    e.mean_motion = tle.MeanMotion();
+    e.bstar = tle.BStar();
+    return e;
+}
+
+int BatchSGP4::Add(const Tle &tle)
+{
+    tle_elements_t e = Elements(tle);
+    SGP4 *fallback = nullptr;
+    try
+    {
+        fallback = new SGP4(tle);
+    }
+    catch (std::exception &ex)
+    {
+        dbprintlf(RED_FG "Rejected elements for %d: %s", e.id, ex.what());
+        return -1;
+    }
+    int retval = init(e, fallback);
+    if (deep.size() == 0 || deep.back() != fallback) // near-earth, not needed
+        delete fallback;
+    return retval;
+}
+
+int BatchSGP4::Add(const tle_elements_t &e)
+{
+    return init(e, nullptr);
+}
+
+int BatchSGP4::init(const tle_elements_t &e, SGP4 *fallback)
+{
+    if ((e.eccentricity < 0) || (e.eccentricity >= 1) || (e.mean_motion <= 0))
+        return -1;
+
+    // recover original mean motion and semi-major axis
+    double no = e.mean_motion * TWOPI / MINUTES_PER_DAY;
+    double a1 = pow(XKE / no, 2.0 / 3.0);
+    double cosio = cos(e.inclination);
+    double sinio = sin(e.inclination);
+    double theta2 = cosio * cosio;
+    double x3thm1 = 3.0 * theta2 - 1.0;
+    double eosq = e.eccentricity * e.eccentricity;
+    double betao2 = 1.0 - eosq;
+    double betao = sqrt(betao2);
+    double temp = (1.5 * CK2) * x3thm1 / (betao * betao2);
+    double del1 = temp / (a1 * a1);
+    double a0 = a1 * (1.0 - del1 * (1.0 / 3.0 + del1 * (1.0 + del1 * 134.0 / 81.0)));
+    double del0 = temp / (a0 * a0);
+    double xnodp = no / (1.0 + del0);
+    double aodp = a0 / (1.0 - del0);
+    double period = TWOPI / xnodp;
+
+    bool is_deep = period >= BATCH_SGP4_DEEP_PERIOD;
+    if (is_deep && (fallback == nullptr))
+        return -2;
+
+    // perigee dependent drag constants
+    double perigee = (aodp * (1.0 - e.eccentricity) - 1.0) * XKMPER;
+    double s4 = S0;
+    double qoms24 = QOMS2T;
+    if (perigee < 156.0)
+    {
+        s4 = perigee - 78.0;
+        if (perigee < 98.0)
+            s4 = 20.0;
+        qoms24 = pow((120.0 - s4) / XKMPER, 4.0);
+        s4 = s4 / XKMPER + 1.0;
+    }
+    double pinvsq = 1.0 / (aodp * aodp * betao2 * betao2);
+    double tsi = 1.0 / (aodp - s4);
+    double eta = aodp * e.eccentricity * tsi;
+    double etasq = eta * eta;
+    double eeta = e.eccentricity * eta;
+    double psisq = fabs(1.0 - etasq);
+    double coef = qoms24 * pow(tsi, 4.0);
+    double coef1 = coef / pow(psisq, 3.5);
+    double c2 = coef1 * xnodp * (aodp * (1.0 + 1.5 * etasq + eeta * (4.0 + etasq)) + 0.75 * CK2 * tsi / psisq * x3thm1 * (8.0 + 3.0 * etasq * (8.0 + etasq)));
+    double c1 = e.bstar * c2;
+    double c3 = 0;
+    if (e.eccentricity > 1.0e-4)
+        c3 = coef * tsi * A3OVK2 * xnodp * sinio / e.eccentricity;
+    double x1mth2 = 1.0 - theta2;
+    double c4 = 2.0 * xnodp * coef1 * aodp * betao2 * (eta * (2.0 + 0.5 * etasq) + e.eccentricity * (0.5 + 2.0 * etasq) - 2.0 * CK2 * tsi / (aodp * psisq) * (-3.0 * x3thm1 * (1.0 - 2.0 * eeta + etasq * (1.5 - 0.5 * eeta)) + 0.75 * x1mth2 * (2.0 * etasq - eeta * (1.0 + etasq)) * cos(2.0 * e.arg_perigee)));
+    double theta4 = theta2 * theta2;
+    double temp1 = 3.0 * CK2 * pinvsq * xnodp;
+    double temp2 = temp1 * CK2 * pinvsq;
+    double temp3 = 1.25 * CK4 * pinvsq * pinvsq * xnodp;
+    double xmdot = xnodp + 0.5 * temp1 * betao * x3thm1 + 0.0625 * temp2 * betao * (13.0 - 78.0 * theta2 + 137.0 * theta4);
+    double x1m5th = 1.0 - 5.0 * theta2;
+    double omgdot = -0.5 * temp1 * x1m5th + 0.0625 * temp2 * (7.0 - 114.0 * theta2 + 395.0 * theta4) + temp3 * (3.0 - 36.0 * theta2 + 49.0 * theta4);
+    double xhdot1 = -temp1 * cosio;
+    double xnodot = xhdot1 + (0.5 * temp2 * (4.0 - 19.0 * theta2) + 2.0 * temp3 * (3.0 - 7.0 * theta2)) * cosio;
+    double xnodcf = 3.5 * betao2 * xhdot1 * c1;
+    double t2cof = 1.5 * c1;
+    double xlcof;
+    if (fabs(cosio + 1.0) > 1.5e-12)
+        xlcof = 0.125 * A3OVK2 * sinio * (3.0 + 5.0 * cosio) / (1.0 + cosio);
+    else
+        xlcof = 0.125 * A3OVK2 * sinio * (3.0 + 5.0 * cosio) / 1.5e-12;
+    double aycof = 0.25 * A3OVK2 * sinio;
+    double x7thm1 = 7.0 * theta2 - 1.0;
+
+    bool simple = perigee < 220.0;
+    double c5 = 0, omgcof = 0, xmcof = 0, delmo = 0, sinmo = 0, d2 = 0, d3 = 0, d4 = 0, t3cof = 0, t4cof = 0, t5cof = 0;
+    if (!simple)
+    {
+        c5 = 2.0 * coef1 * aodp * betao2 * (1.0 + 2.75 * (etasq + eeta) + eeta * etasq);
+        omgcof = e.bstar * c3 * cos(e.arg_perigee);
+        if (e.eccentricity > 1.0e-4)
+            xmcof = -2.0 / 3.0 * coef * e.bstar / eeta;
+        delmo = pow(1.0 + eta * cos(e.mean_anomaly), 3.0);
+        sinmo = sin(e.mean_anomaly);
+        double c1sq = c1 * c1;
+        d2 = 4.0 * aodp * tsi * c1sq;
+        double tmp = d2 * tsi * c1 / 3.0;
+        d3 = (17.0 * aodp + s4) * tmp;
+        d4 = 0.5 * tmp * aodp * tsi * (221.0 * aodp + 31.0 * s4) * c1;
+        t3cof = d2 + 2.0 * c1sq;
+        t4cof = 0.25 * (3.0 * d3 + c1 * (12.0 * d2 + 10.0 * c1sq));
+        t5cof = 0.2 * (3.0 * d4 + 12.0 * c1 * d3 + 6.0 * d2 * d2 + 15.0 * c1sq * (2.0 * d2 + c1sq));
+    }
+
+    el.xmo.push_back(e.mean_anomaly);
+    el.omegao.push_back(e.arg_perigee);
+    el.xnodeo.push_back(e.raan);
+    el.eo.push_back(e.eccentricity);
+    el.xincl.push_back(e.inclination);
+    el.bstar.push_back(e.bstar);
+    el.xnodp.push_back(xnodp);
+    el.aodp.push_back(aodp);
+    el.cosio.push_back(cosio);
+    el.sinio.push_back(sinio);
+    el.x3thm1.push_back(x3thm1);
+    el.x1mth2.push_back(x1mth2);
+    el.x7thm1.push_back(x7thm1);
+    el.xlcof.push_back(xlcof);
+    el.aycof.push_back(aycof);
+    el.c1.push_back(c1);
+    el.c4.push_back(c4);
+    el.c5.push_back(c5);
+    el.xmdot.push_back(xmdot);
+    el.omgdot.push_back(omgdot);
+    el.xnodot.push_back(xnodot);
+    el.xnodcf.push_back(xnodcf);
+    el.t2cof.push_back(t2cof);
+    el.t3cof.push_back(t3cof);
+    el.t4cof.push_back(t4cof);
+    el.t5cof.push_back(t5cof);
+    el.omgcof.push_back(omgcof);
+    el.xmcof.push_back(xmcof);
+    el.eta.push_back(eta);
+    el.delmo.push_back(delmo);
+    el.sinmo.push_back(sinmo);
+    el.d2.push_back(d2);
+    el.d3.push_back(d3);
+    el.d4.push_back(d4);
+    el.simple.push_back(simple ? 1.0 : 0.0);
+    ids.push_back(e.id);
+    epochs.push_back(e.epoch);
+    deep.push_back(is_deep ? fallback : nullptr);
+    return ids.size() - 1;
+}
+
+/**
+ * @brief cos() through sin(), so that GCC does not merge a sin/cos pair into a scalar sincos
+ * call that has no vector variant.
+ *
+ */
+static inline double vcos(double x)
+{
+    return sin(x + M_PI_2);
+}
+
+/**
+ * @brief The lane loops, one block of BATCH_SGP4_BLOCK lanes at a time. Each stage is a
+ * separate loop over the block so every loop body is straight-line code. `Same` broadcasts
+ * object `obj` to every lane.
+ *
+ */
+template <bool Same>
+static inline __attribute__((always_inline)) void kernel(const BatchSGP4::soa_t &el, long obj, const double *__restrict tsince, size_t lo, size_t hi, batch_state_t &out)
+{
+    double *__restrict ox = out.x.data();
+    double *__restrict oy = out.y.data();
+    double *__restrict oz = out.z.data();
+    double *__restrict ovx = out.vx.data();
+    double *__restrict ovy = out.vy.data();
+    double *__restrict ovz = out.vz.data();
+    int *__restrict ostat = out.status.data();
+    double a[BATCH_SGP4_BLOCK], xnode[BATCH_SGP4_BLOCK], axn[BATCH_SGP4_BLOCK], ayn[BATCH_SGP4_BLOCK];
+    double capu[BATCH_SGP4_BLOCK], epw[BATCH_SGP4_BLOCK], delta[BATCH_SGP4_BLOCK];
+    int stat[BATCH_SGP4_BLOCK];
+#define E(term) el.term[Same ? obj : i]
+    for (size_t b = lo; b < hi; b += BATCH_SGP4_BLOCK)
+    {
+        const size_t n = std::min<size_t>(BATCH_SGP4_BLOCK, hi - b);
+
+        // secular gravity and atmospheric drag, long period periodics
+#pragma omp simd
+        for (size_t j = 0; j < n; j++)
+        {
+            const size_t i = b + j;
+            const double t = tsince[i];
+            const double bstar = E(bstar);
+            const double xmdf = E(xmo) + E(xmdot) * t;
+            const double omgadf = E(omegao) + E(omgdot) * t;
+            const double xnoddf = E(xnodeo) + E(xnodot) * t;
+            const double tsq = t * t;
+            const double tcube = tsq * t;
+            const double tfour = t * tcube;
+            // full drag terms, masked off for low perigee
+            const double full = 1.0 - E(simple);
+            const double cm = 1.0 + E(eta) * vcos(xmdf);
+            const double dtemp = (E(omgcof) * t + E(xmcof) * (cm * cm * cm - E(delmo))) * full;
+            const double xmp = xmdf + dtemp;
+            const double omega = omgadf - dtemp;
+            const double tempa = 1.0 - E(c1) * t - full * (E(d2) * tsq + E(d3) * tcube + E(d4) * tfour);
+            const double tempe = bstar * E(c4) * t + full * bstar * E(c5) * (sin(xmp) - E(sinmo));
+            const double templ = E(t2cof) * tsq + full * (E(t3cof) * tcube + tfour * (E(t4cof) + t * E(t5cof)));
+            const double node = xnoddf + E(xnodcf) * tsq;
+            const double sma = E(aodp) * tempa * tempa;
+            double e = E(eo) - tempe;
+            int status = (e <= -0.001) || (e >= 1.0) ? -1 : 1;
+            e = e < 1.0e-6 ? 1.0e-6 : e;
+            const double xl = xmp + omega + node + E(xnodp) * templ;
+            const double beta2 = 1.0 - e * e;
+            const double temp11 = 1.0 / (sma * beta2);
+            const double ax = e * vcos(omega);
+            const double ay = e * sin(omega) + temp11 * E(aycof);
+            const double xlt = xl + temp11 * E(xlcof) * ax;
+            status = ax * ax + ay * ay >= 1.0 ? -1 : status;
+            const double u = xlt - node;
+            a[j] = sma;
+            xnode[j] = node;
+            axn[j] = ax;
+            ayn[j] = ay;
+            capu[j] = u - TWOPI * trunc(u / TWOPI);
+            epw[j] = capu[j];
+            stat[j] = status;
+        }
+
+        // Kepler's equation, the first step is clamped
+#pragma omp simd
+        for (size_t j = 0; j < n; j++)
+        {
+            const double s = sin(epw[j]), c = vcos(epw[j]);
+            const double f = capu[j] - epw[j] + axn[j] * s - ayn[j] * c;
+            const double fdot = 1.0 - axn[j] * c - ayn[j] * s;
+            const double maxstep = 1.25 * sqrt(axn[j] * axn[j] + ayn[j] * ayn[j]);
+            double d = f / fdot;
+            d = d > maxstep ? maxstep : (d < -maxstep ? -maxstep : d);
+            delta[j] = d;
+            epw[j] += d;
+        }
+        for (int k = 1; k < BATCH_SGP4_KEPLER_ITER; k++)
+        {
+#pragma omp simd
+            for (size_t j = 0; j < n; j++)
+            {
+                const double s = sin(epw[j]), c = vcos(epw[j]);
+                const double esine = axn[j] * s - ayn[j] * c;
+                const double f = capu[j] - epw[j] + esine;
+                const double fdot = 1.0 - axn[j] * c - ayn[j] * s;
+                const double d = f / (fdot + 0.5 * esine * delta[j]);
+                delta[j] = d;
+                epw[j] += d;
+            }
+        }
+
+        // short period periodics and the final state vector
+#pragma omp simd
+        for (size_t j = 0; j < n; j++)
+        {
+            const size_t i = b + j;
+            const double sinepw = sin(epw[j]), cosepw = vcos(epw[j]);
+            const double ax = axn[j], ay = ayn[j], sma = a[j];
+            const double ecose = ax * cosepw + ay * sinepw;
+            const double esine = ax * sinepw - ay * cosepw;
+            const double elsq = ax * ax + ay * ay;
+            const double xn = XKE / (sma * sqrt(sma));
+            const double temp21 = 1.0 - elsq;
+            const double pl = sma * temp21;
+            int status = pl < 0.0 ? -1 : stat[j];
+            const double r = sma * (1.0 - ecose);
+            const double temp31 = 1.0 / r;
+            const double rdot = XKE * sqrt(sma) * esine * temp31;
+            const double rfdot = XKE * sqrt(fabs(pl)) * temp31;
+            const double temp32 = sma * temp31;
+            const double betal = sqrt(fabs(temp21));
+            const double temp33 = 1.0 / (1.0 + betal);
+            const double cosu = temp32 * (cosepw - ax + ay * esine * temp33);
+            const double sinu = temp32 * (sinepw - ay - ax * esine * temp33);
+            const double u = atan2(sinu, cosu);
+            const double sin2u = 2.0 * sinu * cosu;
+            const double cos2u = 2.0 * cosu * cosu - 1.0;
+            const double temp41 = 1.0 / pl;
+            const double temp42 = CK2 * temp41;
+            const double temp43 = temp42 * temp41;
+
+            const double rk = r * (1.0 - 1.5 * temp43 * betal * E(x3thm1)) + 0.5 * temp42 * E(x1mth2) * cos2u;
+            const double uk = u - 0.25 * temp43 * E(x7thm1) * sin2u;
+            const double xnodek = xnode[j] + 1.5 * temp43 * E(cosio) * sin2u;
+            const double xinck = E(xincl) + 1.5 * temp43 * E(cosio) * E(sinio) * cos2u;
+            const double rdotk = rdot - xn * temp42 * E(x1mth2) * sin2u;
+            const double rfdotk = rfdot + xn * temp42 * (E(x1mth2) * cos2u + 1.5 * E(x3thm1));
+            status = rk < 1.0 ? -1 : status;
+
+            // orientation vectors
+            const double sinuk = sin(uk), cosuk = vcos(uk);
+            const double sinik = sin(xinck), cosik = vcos(xinck);
+            const double sinnok = sin(xnodek), cosnok = vcos(xnodek);
+            const double xmx = -sinnok * cosik;
+            const double xmy = cosnok * cosik;
+            const double ux = xmx * sinuk + cosnok * cosuk;
+            const double uy = xmy * sinuk + sinnok * cosuk;
+            const double uz = sinik * sinuk;
+            const double vx = xmx * cosuk - cosnok * sinuk;
+            const double vy = xmy * cosuk - sinnok * sinuk;
+            const double vz = sinik * cosuk;
+
+            const double vscale = XKMPER / 60.0;
+            ox[i] = rk * ux * XKMPER;
+            oy[i] = rk * uy * XKMPER;
+            oz[i] = rk * uz * XKMPER;
+            ovx[i] = (rdotk * ux + rfdotk * vx) * vscale;
+            ovy[i] = (rdotk * uy + rfdotk * vy) * vscale;
+            ovz[i] = (rdotk * uz + rfdotk * vz) * vscale;
+            ostat[i] = status;
+        }
+    }
+#undef E
+}
+
+BATCH_CLONES static void kernel_objects(const BatchSGP4::soa_t &el, const double *tsince, size_t lo, size_t hi, batch_state_t &out)
+{
+    kernel<false>(el, 0, tsince, lo, hi, out);
+}
+
+BATCH_CLONES static void kernel_epochs(const BatchSGP4::soa_t &el, long obj, const double *tsince, size_t lo, size_t hi, batch_state_t &out)
+{
+    kernel<true>(el, obj, tsince, lo, hi, out);
+}
+
+void BatchSGP4::Kernel(const soa_t &el, long obj, const double *tsince, size_t lo, size_t hi, batch_state_t &out)
+{
+    if (obj < 0)
+        kernel_objects(el, tsince, lo, hi, out);
+    else
+        kernel_epochs(el, obj, tsince, lo, hi, out);
+}
+
+void BatchSGP4::fallback(size_t obj, const double *tsince, size_t lo, size_t hi, bool same_object, batch_state_t &out) const
+{
+    for (size_t i = lo; i < hi; i++)
+    {
+        SGP4 *sgp = deep[same_object ? obj : i];
+        if (sgp == nullptr)
+            continue;
+        try
+        {
+            Eci eci = sgp->FindPosition(tsince[i]);
+            Vector p = eci.Position(), v = eci.Velocity();
+            out.x[i] = p.x;
+            out.y[i] = p.y;
+            out.z[i] = p.z;
+            out.vx[i] = v.x;
+            out.vy[i] = v.y;
+            out.vz[i] = v.z;
+            out.status[i] = 1;
+        }
+        catch (std::exception &e)
+        {
+            out.status[i] = -2;
+        }
+    }
+}
+
+void BatchSGP4::Run(long obj, const double *tsince, size_t lo, size_t hi, batch_state_t &out) const
+{
+    Kernel(el, obj, tsince, lo, hi, out);
+    if (obj >= 0)
+    {
+        if (deep[obj] != nullptr)
+            fallback(obj, tsince, lo, hi, true, out);
+        return;
+    }
+    for (size_t i = lo; i < hi; i++)
+        if (deep[i] != nullptr)
+            fallback(i, tsince, i, i + 1, false, out);
+}
+
+typedef struct
+{
+    const BatchSGP4 *batch;
+    long obj;
+    const double *tsince;
+    size_t lo, hi;
+    batch_state_t *out;
+    pthread_t tid;
+    bool started;
+} batch_work_t;
+
+static void *batch_worker(void *args)
+{
+    batch_work_t *w = (batch_work_t *)args;
+    w->batch->Run(w->obj, w->tsince, w->lo, w->hi, *w->out);
+    return NULL;
+}
+
+static void resize(batch_state_t &out, size_t n)
+{
+    out.x.resize(n);
+    out.y.resize(n);
+    out.z.resize(n);
+    out.vx.resize(n);
+    out.vy.resize(n);
+    out.vz.resize(n);
+    out.status.resize(n);
+}
+
+/**
+ * @brief Split [0, n) into chunks of whole cache lines and run each on its own thread.
+ *
+ */
+static void split(const BatchSGP4 *batch, long obj, const double *tsince, size_t n, batch_state_t &out, int nthreads)
+{
+    if (nthreads <= 0)
+        nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t chunk = (n + nthreads - 1) / nthreads;
+    chunk = (chunk + 7) & ~(size_t)7;
+    if ((nthreads <= 1) || (chunk >= n))
+    {
+        batch->Run(obj, tsince, 0, n, out);
+        return;
+    }
+    std::vector<batch_work_t> work((n + chunk - 1) / chunk);
+    for (size_t i = 0; i < work.size(); i++)
+    {
+        batch_work_t w = {batch, obj, tsince, i * chunk, std::min(n, (i + 1) * chunk), &out, 0, false};
+        work[i] = w;
+        if (i > 0)
+            work[i].started = pthread_create(&work[i].tid, NULL, batch_worker, &work[i]) == 0;
+    }
+    batch->Run(obj, tsince, work[0].lo, work[0].hi, out);
+    for (size_t i = 1; i < work.size(); i++)
+    {
+        if (work[i].started)
+            pthread_join(work[i].tid, NULL);
+        else // could not spawn, run it here instead
+            batch->Run(obj, tsince, work[i].lo, work[i].hi, out);
+    }
+}
+
+int BatchSGP4::Propagate(const DateTime &dt, batch_state_t &out, int nthreads) const
+{
+    size_t n = ids.size();
+    resize(out, n);
+    std::vector<double> tsince(n);
+    for (size_t i = 0; i < n; i++)
+        tsince[i] = (dt.Ticks() - epochs[i]) / 60.0e6; // minutes
+    split(this, -1, tsince.data(), n, out, nthreads);
+    int ok = 0;
+    for (size_t i = 0; i < n; i++)
+        ok += out.status[i] > 0;
+    return ok;
+}
+
+int BatchSGP4::PropagateTimes(size_t idx, const DateTime *times, size_t count, batch_state_t &out, int nthreads) const
+{
+    if (idx >= ids.size())
+        return -1;
+    resize(out, count);
+    std::vector<double> tsince(count);
+    for (size_t i = 0; i < count; i++)
+        tsince[i] = (times[i].Ticks() - epochs[idx]) / 60.0e6; // minutes
+    split(this, idx, tsince.data(), count, out, nthreads);
+    int ok = 0;
+    for (size_t i = 0; i < count; i++)
+        ok += out.status[i] > 0;
+    return ok;
+}
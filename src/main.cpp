@@ -13,17 +13,29 @@
 #include <unistd.h>
 #include <string.h>
 #include <TargetSystem.hpp>
+#include "track.hpp"
+#include "SessionLog.hpp"
+#include "TleCatalog.hpp"
+#include "TickScheduler.hpp"
+#include "NetEngine.hpp"
+#include "RingLog.hpp"
 #include "clkgen.h"
 #include "meb_debug.h"
 #include <signal.h>
 
 volatile sig_atomic_t done = 0;
+volatile sig_atomic_t dump_stats = 0;
 
 void sighandler(int sig)
 {
     done = 1;
 }
 
+void sigusr1_handler(int sig)
+{
+    dump_stats = 1;
+}
+
 int main(int argc, char *argv[])
 {
     // Ignores broken pipe signal, which is sent to the calling process when writing to a nonexistent socket (
@@ -33,6 +45,12 @@ int main(int argc, char *argv[])
     // Allows manual handling of a broken pipe signal using 'if (errno == EPIPE) {...}'.
     // Broken pipe signal will crash the process, and it caused by sending data to a closed socket.
     signal(SIGPIPE, SIG_IGN);
+    // Ctrl+C leaves the main loop, so the latency histograms are printed on the way out.
+    signal(SIGINT, sighandler);
+    // kill -USR1 prints the latency histograms.
+    signal(SIGUSR1, sigusr1_handler);
+    // Log records from the tracking and network paths are formatted off those threads.
+    ringlog().Start(stderr);
 
     // Set up netdata.
     global_data_t global[1] = {0};
@@ -41,21 +59,60 @@ int main(int argc, char *argv[])
 
     strcpy(global->TLE1, DEFAULT_TLE1);
     strcpy(global->TLE2, DEFAULT_TLE2);
+    global->rx_verbose = getenv("TRACK_RX_VERBOSE") != NULL;
+    global->telem_period = TELEM_SEND_PERIOD;
+    global->telem_batch = 0; // as many as fit in a frame
+
+    // Element catalog written by tle_catalog.out, e.g. TRACK_CATALOG=active.tlec TRACK_TARGET=25544.
+    TleCatalog catalog;
+    if (getenv("TRACK_CATALOG") != NULL)
+    {
+        int count = catalog.Open(getenv("TRACK_CATALOG"));
+        if (count < 0)
+        {
+            dbprintlf(RED_FG "Could not open the element catalog %s.", getenv("TRACK_CATALOG"));
+        }
+        else
+        {
+            dbprintlf(GREEN_FG "Element catalog %s: %d objects.", getenv("TRACK_CATALOG"), count);
+            global->catalog = &catalog;
+        }
+    }
+    if ((global->catalog != NULL) && (getenv("TRACK_TARGET") != NULL))
+    {
+        const tle_record_t *rec = catalog.Find(atoi(getenv("TRACK_TARGET")));
+        if (rec == NULL)
+        {
+            dbprintlf(RED_FG "Target %s not in the catalog, tracking the default.", getenv("TRACK_TARGET"));
+        }
+        else
+        {
+            strcpy(global->TLE1, rec->line1);
+            strcpy(global->TLE2, rec->line2);
+        }
+    }
 
     // Create GSN thread IDs.
-    pthread_t net_polling_tid, net_rx_tid;
-
-    // TODO: Send a network packet with the current AzEl data each time it is updated. Example below.
-    // { AZ-EL TRACKING DATA REPORT EXAMPLE
-    //     int AzEl[2] = {0};
-    //     AzEl[0] = azimuth;
-    //     AzEl[1] = elevation;
-    //     NetFrame *AzElFrame = new NetFrame((unsigned char *) AzEl, sizeof(AzEl), NetType::TRACKING_DATA, NetVertex::CLIENT);
-    //     AzElFrame->sendFrame(global->netdata);
-    //     delete AzElFrame;
-    // }
+    pthread_t telem_tid;
 
     TargetSystem tsys;
+    // Rotator line speed and dialect, e.g. TRACK_MOTOR_BAUD=9600 TRACK_MOTOR_PROTO=gs232.
+    {
+        int baud = getenv("TRACK_MOTOR_BAUD") != NULL ? atoi(getenv("TRACK_MOTOR_BAUD")) : MOTOR_BAUD;
+        int proto = MOTOR_PROTO_PAPB;
+        if ((getenv("TRACK_MOTOR_PROTO") != NULL) && (strcmp(getenv("TRACK_MOTOR_PROTO"), "gs232") == 0))
+            proto = MOTOR_PROTO_GS232;
+        if (tsys.SetMotor(baud, proto) < 0)
+            dbprintlf(RED_FG "Unsupported rotator baud rate %d, using %d.", baud, MOTOR_BAUD);
+    }
+    // Resume mid-pass after a restart from TRACK_SCHEDULE (TRACK_SCHEDULE_FILE if unset, an
+    // empty value turns it off).
+    {
+        const char *store = getenv("TRACK_SCHEDULE") != NULL ? getenv("TRACK_SCHEDULE") : TRACK_SCHEDULE_FILE;
+        if ((store[0] != '\0') && (tsys.SetStore(store) < 0))
+            dbprintlf(RED_FG "Schedule file path too long, not kept.");
+    }
+    double lat = 42.65578686304611, lon = -71.32546893568428, alt = 8;
     if (argc > 2)
     {
         dbprintlf(FATAL "Invalid number of command-line arguments given.");
@@ -63,50 +120,142 @@ int main(int argc, char *argv[])
     }
     else if (argc == 2)
     {
-        tsys.Create(argv[1], TLE1, TLE2, 42.65578686304611, -71.32546893568428, 1);
+        alt = 1;
+        tsys.Create(argv[1], global->TLE1, global->TLE2, lat, lon, alt);
     }
     else
-        tsys.Create(TLE1, TLE2, 42.65578686304611, -71.32546893568428, 8);
+        tsys.Create(global->TLE1, global->TLE2, lat, lon, alt);
+    global->tsys = &tsys;
+    // Doppler shifts published with the telemetry, e.g. TRACK_DOWNLINK_HZ=437.5e6.
+    {
+        double uplink = getenv("TRACK_UPLINK_HZ") != NULL ? atof(getenv("TRACK_UPLINK_HZ")) : 0;
+        double downlink = getenv("TRACK_DOWNLINK_HZ") != NULL ? atof(getenv("TRACK_DOWNLINK_HZ")) : 0;
+        if (tsys.SetRadio(uplink, downlink) < 0)
+            dbprintlf(RED_FG "Invalid link frequencies, no Doppler shifts.");
+    }
 
-    clkgen_t clk = create_clk(1000000000, tsys.TimerHandler, &tsys);
+    // Record what the tracker is told, for replay with sim.out.
+    SessionLog session;
+    if ((getenv("TRACK_SESSION_LOG") != NULL) && (session.Open(getenv("TRACK_SESSION_LOG"), true) > 0))
+    {
+        session_event_t ev;
+        memset(&ev, 0x0, sizeof(session_event_t));
+        ev.type = SESSION_START;
+        ev.lat = lat;
+        ev.lon = lon;
+        ev.alt = alt;
+        session.Record(DateTime::Now(true), ev);
+        ev.type = SESSION_TLE;
+        strcpy(ev.TLE1, global->TLE1);
+        strcpy(ev.TLE2, global->TLE2);
+        session.Record(DateTime::Now(true), ev);
+        global->session = &session;
+    }
+
+    // Tick rate in Hz, TRACK_TICK_HZ=1..100. TRACK_SCHED=rt runs the tick on a SCHED_FIFO thread
+    // with absolute deadlines, pinned to TRACK_RT_CPU if given; clkgen otherwise or if that fails.
+    // TRACK_SCHED=adaptive runs the same thread but lets the tracker pick each interval, up to
+    // TICK_RATE_MAX in fast segments and none between passes; the tick rate is its first period.
+    double tick_rate = TRACK_TICK_RATE;
+    if (getenv("TRACK_TICK_HZ") != NULL)
+    {
+        tick_rate = atof(getenv("TRACK_TICK_HZ"));
+        if ((tick_rate < TICK_RATE_MIN) || (tick_rate > TICK_RATE_MAX))
+        {
+            dbprintlf(RED_FG "Tick rate %s out of range, using %d Hz.", getenv("TRACK_TICK_HZ"), TRACK_TICK_RATE);
+            tick_rate = TRACK_TICK_RATE;
+        }
+    }
+    tsys.SetTickPeriod(1.0 / tick_rate);
+    TickScheduler sched;
+    clkgen_t clk = NULL;
+    if ((getenv("TRACK_SCHED") != NULL) && (strcmp(getenv("TRACK_SCHED"), "rt") == 0))
+    {
+        int cpu = getenv("TRACK_RT_CPU") != NULL ? atoi(getenv("TRACK_RT_CPU")) : -1;
+        if (sched.Start(tick_rate, tsys.TickHandler, &tsys, cpu) < 0)
+        {
+            dbprintlf(RED_FG "Could not start the tick thread, using clkgen.");
+        }
+    }
+    else if ((getenv("TRACK_SCHED") != NULL) && (strcmp(getenv("TRACK_SCHED"), "adaptive") == 0))
+    {
+        int cpu = getenv("TRACK_RT_CPU") != NULL ? atoi(getenv("TRACK_RT_CPU")) : -1;
+        tsys.SetTickWake(TickScheduler::WakeHandler, &sched);
+        if (sched.StartAdaptive(tick_rate, tsys.TickHandler, tsys.TickInterval, &tsys, cpu) < 0)
+        {
+            tsys.SetTickWake(NULL, NULL);
+            dbprintlf(RED_FG "Could not start the adaptive tick thread, using clkgen.");
+        }
+    }
+    if (!sched.IsRunning())
+        clk = create_clk((long long)(1e9 / tick_rate), tsys.TimerHandler, &tsys);
+
+    // One thread receives, sends, polls and reconnects. TRACK_SERVER=host[:port] overrides the
+    // server, e.g. 127.0.0.1 for tools/net_server.out.
+    NetEngine net;
+    const char *server = getenv("TRACK_SERVER") != NULL ? getenv("TRACK_SERVER") : NET_SERVER_HOST;
+    if (net.Start(global->netdata, server, gs_network_rx, global) < 0)
+    {
+        dbprintlf(FATAL "Could not start the network engine for %s.", server);
+        return -1;
+    }
+    global->net = &net;
+
+    // Pointing telemetry goes out in batches, independent of the tick rate.
+    global->telem_active = true;
+    if (pthread_create(&telem_tid, NULL, gs_telemetry_thread, global) != 0)
+    {
+        dbprintlf(RED_FG "Could not start the telemetry thread.");
+        global->telem_active = false;
+    }
 
     printf("Running tracker, Ctrl+C to exit\n");
 
     while (!done)
     {
-        // Not initialized or recoverable failure - thread boot required.
-        if (global->netdata->thread_status == 0)
+        tracker_state_t st;
+        if (tsys.GetState(st) > 0) // published by the tracking tick, no propagation here
+            printf("Target %d location: %d %d | %3.2lf %3.2lf %3.2lf\n", st.target, (int)st.az, (int)st.el, st.lat, st.lon, st.alt);
+        if (dump_stats)
         {
-            if (global->netdata->connection_ready)
+            dump_stats = 0;
+            instruments().Dump(stderr);
+            motor_stats_t ms = tsys.GetMotorStats();
+            fprintf(stderr, "rotator: %d sent, %d errors, %d skipped, %d resent, %d reports, %d missed\n", ms.sent, ms.errors, ms.skipped, ms.resent, ms.reports, ms.missed);
+            if (sched.IsRunning())
             {
-                dbprintlf(YELLOW_FG "(Re)Booting network receive and poll threads.");
-                pthread_create(&net_polling_tid, NULL, gs_polling_thread, global->netdata);
-                pthread_create(&net_rx_tid, NULL, gs_network_rx_thread, global);
-            }
-            else
-            {
-                dbprintlf(RED_FG "Cannot reboot network receive and poll threads, connection not ready.");
+                tick_stats_t ts = sched.GetStats();
+                fprintf(stderr, "tick: %llu ticks, %llu deadlines missed%s%s\n", (unsigned long long)ts.ticks, (unsigned long long)ts.missed, ts.realtime ? ", SCHED_FIFO" : "", ts.pinned ? ", pinned" : "");
+                double saved = ts.ticks > 0 && ts.fixed > ts.ticks ? ts.cpu / ts.ticks * (ts.fixed - ts.ticks) : 0; // at this run's CPU per tick
+                fprintf(stderr, "tick: %.3f s CPU, %llu ticks at a fixed %.0f Hz, ~%.3f s CPU saved, %llu early wake-ups\n", ts.cpu, (unsigned long long)ts.fixed, tick_rate, saved, (unsigned long long)ts.woken);
             }
+            net_stats_t ns = net.GetStats();
+            fprintf(stderr, "log: %lu records dropped\n", (unsigned long)ringlog().Dropped());
+            fprintf(stderr, "network: %d connects, %d disconnects, %d failed, last reconnect %.1f ms, %d sent, %d dropped, %d received\n", ns.connects, ns.disconnects, ns.failures, ns.reconnect_ms, ns.sent, ns.dropped, ns.received);
         }
-
-        CoordTopocentric coord = tsys.GetPosition();
-        CoordGeodetic geo = tsys.GetGeoPosition();
-        printf("Target location: %d %d | %3.2lf %3.2lf %3.2lf\n", (int)coord.azimuth, (int)coord.elevation, geo.latitude, geo.longitude, geo.altitude);
-
-        // Send target location through the network.
-        track_data_t *info = {0};
-        info.az = (int)coord.azimuth;
-        info.el = (int)coord.elevation;
-        info.lat = geo.latitude;
-        info.lon = geo.longitude;
-        info.alt = geo.altitude;
-        NetFrame *dataFrame = new NetFrame((unsigned char *) info, sizeof(track_data_t), NetType::TRACKING_DATA, NetVertex::CLIENT);
-        dataFrame->sendFrame(global->netdata);
-        delete dataFrame;
         sleep(1);
     }
 
-    destroy_clk(clk);
+    if (clk != NULL)
+        destroy_clk(clk);
+    sched.Stop();
+    instruments().Dump(stderr);
+
+    if (global->session != NULL)
+    {
+        session_event_t ev;
+        memset(&ev, 0x0, sizeof(session_event_t));
+        ev.type = SESSION_END;
+        global->session->Record(DateTime::Now(true), ev);
+    }
+
+    if (global->telem_active)
+    {
+        global->telem_active = false;
+        pthread_join(telem_tid, NULL);
+    }
+    net.Stop();
+    ringlog().Stop();
 
     return 0;
 }
\ No newline at end of file
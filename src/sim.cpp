@@ -0,0 +1,346 @@
+/**
+ * @file sim.cpp
+ * @brief Runs the tracker against a virtual clock, faster than real time, or replays a recorded
+ * session.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * Usage: sim.out [-d days] [-r rate] [-s session.log] [-o telemetry.csv] [-u Hz] [-l Hz] [-a] [TLE file]
+ *   -d  simulated duration in days, default 1; a replay runs to the END of the log
+ *   -r  speed relative to real time, 0 (default) runs as fast as possible
+ *   -s  replay a session recorded with TRACK_SESSION_LOG
+ *   -o  write every telemetry sample as CSV
+ *   -u  uplink frequency, -l downlink frequency, for the Doppler shifts in the CSV
+ *   -a  adaptive tick: step the clock by the tracker's own NextTick() instead of TRACK_TICK_RATE
+ * Targets come from the TLE file (pairs of element lines) or from the session log.
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <vector>
+#include "TargetSystem.hpp"
+#include "TrackClock.hpp"
+#include "SessionLog.hpp"
+#include "track.hpp"
+#include "meb_debug.h"
+
+#define SIM_LAT 42.65578686304611
+#define SIM_LON -71.32546893568428
+#define SIM_ALT 0.008 // km
+
+/**
+ * @brief Tracking window seen in the telemetry, with the tick CPU spent on it.
+ *
+ */
+typedef struct
+{
+    int target;
+    int64_t start_us;
+    int64_t end_us;
+    long ticks;
+    double cpu; // seconds
+    plan_report_t plan;
+} sim_pass_t;
+
+static volatile bool draining = true;
+
+static void *drain_pty(void *p)
+{
+    int fd = *(int *)p;
+    char buf[256];
+    while (draining)
+        if (read(fd, buf, sizeof(buf)) <= 0)
+            usleep(1000);
+    return NULL;
+}
+
+static double cpu_now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static double wall_now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int apply(TargetSystem &tsys, const session_event_t &ev)
+{
+    switch (ev.type)
+    {
+    case SESSION_TLE:
+        return tsys.UpdateTLE(ev.TLE1, ev.TLE2, ev.priority);
+    case SESSION_REMOVE:
+        return tsys.RemoveTarget(ev.target);
+    case SESSION_PRIORITY:
+        return tsys.SetPriority(ev.target, ev.priority);
+    case SESSION_OBS:
+        return tsys.UpdateObs(ev.lat, ev.lon, ev.alt);
+    default:
+        return 1;
+    }
+}
+
+static void report(const sim_pass_t &p)
+{
+    printf("Pass %6d: %7.1f min from start, %6.1f s, %6ld ticks, %8.3f ms tick CPU; plan %s%s, %d swings, %5.1f s slew, %5.1f s lost\n", p.target, p.start_us / 60e6, (p.end_us - p.start_us) * 1e-6, p.ticks, p.cpu * 1e3, p.plan.mode == PLAN_OFFSET ? "offset" : "direct", p.plan.flip ? "/flip" : "", p.plan.swings, p.plan.slew, p.plan.loss);
+}
+
+int main(int argc, char *argv[])
+{
+    double days = 1, rate = 0, uplink = 0, downlink = 0;
+    bool adaptive = false;
+    const char *session_name = NULL, *csv_name = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "d:r:s:o:u:l:a")) != -1)
+    {
+        switch (opt)
+        {
+        case 'd':
+            days = atof(optarg);
+            break;
+        case 'r':
+            rate = atof(optarg);
+            break;
+        case 's':
+            session_name = optarg;
+            break;
+        case 'o':
+            csv_name = optarg;
+            break;
+        case 'u':
+            uplink = atof(optarg);
+            break;
+        case 'l':
+            downlink = atof(optarg);
+            break;
+        case 'a':
+            adaptive = true;
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-d days] [-r rate] [-s session.log] [-o telemetry.csv] [-u Hz] [-l Hz] [-a] [TLE file]\n", argv[0]);
+            return -1;
+        }
+    }
+
+    // inputs: a session to replay, or a start time, observer and targets
+    std::vector<session_event_t> events;
+    session_event_t start;
+    memset(&start, 0x0, sizeof(session_event_t));
+    start.type = SESSION_START;
+    start.ticks = DateTime::Now(true).Ticks();
+    start.lat = SIM_LAT;
+    start.lon = SIM_LON;
+    start.alt = SIM_ALT;
+    DateTime end = DateTime(start.ticks).AddSeconds(days * 86400);
+    if (session_name != NULL)
+    {
+        SessionLog log;
+        if (log.Open(session_name, false) < 0)
+        {
+            dbprintlf(FATAL "Could not open %s", session_name);
+            return -1;
+        }
+        session_event_t ev;
+        int retval;
+        while ((retval = log.Next(ev)) > 0)
+        {
+            if (ev.type == SESSION_START)
+                start = ev;
+            else
+                events.push_back(ev);
+            if (ev.type == SESSION_END)
+                end = DateTime(ev.ticks);
+        }
+        if (retval < 0)
+        {
+            dbprintlf(FATAL "Malformed session log %s", session_name);
+            return -1;
+        }
+    }
+    if (optind < argc)
+    {
+        FILE *fp = fopen(argv[optind], "r");
+        if (fp == NULL)
+        {
+            dbprintlf(FATAL "Could not open %s", argv[optind]);
+            return -1;
+        }
+        session_event_t ev;
+        memset(&ev, 0x0, sizeof(session_event_t));
+        ev.type = SESSION_TLE;
+        ev.ticks = start.ticks;
+        char buf[SESSION_LINE_MAX];
+        while (fgets(buf, sizeof(buf), fp) != NULL)
+        {
+            buf[strcspn(buf, "\r\n")] = '\0';
+            if ((buf[0] == '1') && (strlen(buf) < sizeof(ev.TLE1)))
+                strcpy(ev.TLE1, buf);
+            else if ((buf[0] == '2') && (ev.TLE1[0] == '1') && (strlen(buf) < sizeof(ev.TLE2)))
+            {
+                strcpy(ev.TLE2, buf);
+                events.insert(events.begin(), ev);
+                ev.TLE1[0] = '\0';
+            }
+        }
+        fclose(fp);
+    }
+    if ((events.size() == 0) || (events[0].type != SESSION_TLE))
+    {
+        session_event_t ev;
+        memset(&ev, 0x0, sizeof(session_event_t));
+        ev.type = SESSION_TLE;
+        ev.ticks = start.ticks;
+        strcpy(ev.TLE1, DEFAULT_TLE1);
+        strcpy(ev.TLE2, DEFAULT_TLE2);
+        events.insert(events.begin(), ev);
+    }
+
+    int master = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if ((master < 0) || (grantpt(master) < 0) || (unlockpt(master) < 0))
+    {
+        dbprintlf(FATAL "Could not open a pseudo-terminal for the motor");
+        return -1;
+    }
+    pthread_t drain_tid;
+    pthread_create(&drain_tid, NULL, drain_pty, &master);
+
+    FILE *csv = NULL;
+    if (csv_name != NULL)
+    {
+        csv = fopen(csv_name, "w");
+        if (csv == NULL)
+        {
+            dbprintlf(FATAL "Could not open %s", csv_name);
+            return -1;
+        }
+        fprintf(csv, "time_us,target,cmd_az,cmd_el,pred_az,pred_el,range_rate,range,dl_doppler,ul_doppler,latency_us,flags\n");
+    }
+
+    VirtualClock clk(DateTime(start.ticks));
+    std::vector<sim_pass_t> passes;
+    double tick_cpu = 0, wall_start = wall_now();
+    long ticks = 0;
+    {
+        TargetSystem tsys;
+        tsys.SetClock(&clk);
+        tsys.SetRadio(uplink, downlink);
+        if (tsys.Create(ptsname(master), events[0].TLE1, events[0].TLE2, start.lat, start.lon, start.alt) < 0)
+        {
+            dbprintlf(FATAL "Could not create the target system");
+            return -1;
+        }
+        size_t next = 1;
+        const double step = 1.0 / TRACK_TICK_RATE;
+        const int64_t t0_us = start.ticks;
+        sim_pass_t pass;
+        bool inpass = false;
+        telem_sample_t samples[64];
+        for (DateTime now = clk.Now(); now < end; now = clk.Now())
+        {
+            while ((next < events.size()) && (events[next].ticks <= now.Ticks()))
+                apply(tsys, events[next++]);
+
+            double c0 = cpu_now();
+            tsys.Track();
+            double c1 = cpu_now() - c0;
+            tick_cpu += c1;
+            ticks++;
+            tsys.WaitPlanner();
+
+            int count = tsys.ReadTelemetry(samples, 64);
+            for (int i = 0; i < count; i++)
+            {
+                const telem_sample_t &s = samples[i];
+                if (csv != NULL)
+                    fprintf(csv, "%ld,%d,%.3f,%.3f,%.4f,%.4f,%.5f,%.3f,%.1f,%.1f,%u,%u\n", (long)s.time_us, s.target, s.cmd_az, s.cmd_el, s.pred_az, s.pred_el, s.range_rate, s.range, s.dl_doppler, s.ul_doppler, s.latency_us, s.flags);
+                bool visible = s.flags & TELEM_FLAG_VISIBLE;
+                if (inpass && (!visible || (s.target != pass.target)))
+                {
+                    passes.push_back(pass);
+                    report(pass);
+                    inpass = false;
+                }
+                if (visible && !inpass)
+                {
+                    pass.target = s.target;
+                    pass.start_us = now.Ticks() - t0_us;
+                    pass.ticks = 0;
+                    pass.cpu = 0;
+                    tsys.GetPlan(pass.plan);
+                    inpass = true;
+                }
+                if (inpass)
+                {
+                    pass.end_us = now.Ticks() - t0_us;
+                    pass.ticks++;
+                    pass.cpu += c1;
+                }
+            }
+
+            if (rate > 0) // hold the simulation to `rate` times real time
+            {
+                double ahead = (now.Ticks() - t0_us) * 1e-6 / rate - (wall_now() - wall_start);
+                if (ahead > 0)
+                    usleep(ahead * 1e6);
+            }
+
+            double advance = step;
+            if (adaptive) // as a TickScheduler would, woken early for the next recorded command
+            {
+                advance = tsys.NextTick();
+                if (next < events.size())
+                    advance = std::min(advance, std::max((events[next].ticks - now.Ticks()) * 1e-6, 1.0 / TICK_RATE_MAX));
+            }
+            clk.Advance(advance);
+        }
+        if (inpass)
+        {
+            passes.push_back(pass);
+            report(pass);
+        }
+        double planner_cpu = tsys.GetPlannerCpu();
+        double wall = wall_now() - wall_start;
+        double simulated = (end - DateTime(start.ticks)).TotalSeconds();
+        double pass_cpu = 0, slew = 0, loss = 0;
+        for (size_t i = 0; i < passes.size(); i++)
+        {
+            pass_cpu += passes[i].cpu;
+            slew += passes[i].plan.slew;
+            loss += passes[i].plan.loss;
+        }
+        printf("Simulated %.1f h in %.2f s (%.0fx real time), %ld ticks\n", simulated / 3600, wall, simulated / wall, ticks);
+        printf("Tick CPU %.3f s total, %.2f us per tick; planner CPU %.3f s\n", tick_cpu, tick_cpu / ticks * 1e6, planner_cpu);
+        if (adaptive)
+        {
+            double fixed = simulated * TRACK_TICK_RATE;
+            printf("Adaptive tick: %ld ticks instead of %.0f at %d Hz, ~%.3f s tick CPU saved\n", ticks, fixed, TRACK_TICK_RATE, fixed > ticks ? tick_cpu / ticks * (fixed - ticks) : 0);
+        }
+        if (passes.size() > 0)
+        {
+            printf("%zu passes, %.3f ms tick CPU per pass\n", passes.size(), pass_cpu / passes.size() * 1e3);
+            printf("Planned %.1f s slewing and %.1f s outside the beam over all passes\n", slew, loss);
+        }
+        instruments().Dump(stdout);
+    }
+
+    if (csv != NULL)
+        fclose(csv);
+    draining = false;
+    pthread_join(drain_tid, NULL);
+    close(master);
+    return 0;
+}
@@ -14,127 +14,203 @@
 #include <stdlib.h>
 #include <errno.h>
 #include <string.h>
+#include <pthread.h>
 #include "track.hpp"
 #include "network.hpp"
-#include "meb_debug.hpp"
-
-void *gs_network_rx_thread(void *args)
+#include "meb_debug.h"
+#include "TargetSystem.hpp"
+#include "SessionLog.hpp"
+#include "TleCatalog.hpp"
+#include "Instrument.hpp"
+#include "NetEngine.hpp"
+#include "RingLog.hpp"
+
+static rx_handler_t rx_handlers[256] = {0}; // indexed by NetType
+static pthread_once_t rx_once = PTHREAD_ONCE_INIT;
+
+static int rx_tracking_command(global_data_t *global, NetType type, unsigned char *payload, int payload_size)
 {
-    global_data_t *global = (global_data_t *)args;
-    NetDataClient *netdata = global->netdata;
+    if (global->rx_verbose)
+        rlogf(LOG_DEBUG, BLUE_FG "Received a TRACKING COMMAND frame.");
 
-    while (netdata->recv_active && netdata->thread_status > 0)
+    if (payload_size < (int)sizeof(track_cmd_t))
     {
-        if (!netdata->connection_ready)
+        rlogf(LOG_ERROR, RED_FG "Tracking command too short (%d bytes).", payload_size);
+        return -1;
+    }
+    track_cmd_t *command = (track_cmd_t *)payload;
+    command->TLE1[sizeof(command->TLE1) - 1] = '\0';
+    command->TLE2[sizeof(command->TLE2) - 1] = '\0';
+
+    // resolved here so the session records the elements that were actually used
+    if (command->cmd == CMD_TRACK_ID)
+    {
+        const tle_record_t *rec = global->catalog != NULL ? global->catalog->Find(command->target) : NULL;
+        if (rec == NULL)
         {
-            usleep(5 SEC);
-            continue;
+            rlogf(LOG_ERROR, RED_FG "Target %d not in the catalog.", command->target);
+            return -1;
         }
+        strncpy(command->TLE1, rec->line1, sizeof(command->TLE1) - 1); // terminated above
+        strncpy(command->TLE2, rec->line2, sizeof(command->TLE2) - 1);
+        command->cmd = CMD_UPDATE_TLE;
+    }
 
-        int read_size = 0;
+    if (global->session != NULL) // replayed by sim.out
+    {
+        session_event_t ev;
+        memset(&ev, 0x0, sizeof(session_event_t));
+        ev.type = command->cmd == CMD_UPDATE_TLE ? SESSION_TLE : command->cmd == CMD_REMOVE_TARGET ? SESSION_REMOVE : SESSION_PRIORITY;
+        strcpy(ev.TLE1, command->TLE1);
+        strcpy(ev.TLE2, command->TLE2);
+        ev.target = command->target;
+        ev.priority = command->priority;
+        if ((command->cmd >= CMD_UPDATE_TLE) && (command->cmd <= CMD_SET_PRIORITY))
+            global->session->Record(DateTime::Now(true), ev);
+    }
 
-        while (read_size >= 0 && netdata->recv_active && netdata->thread_status > 0)
+    // UPDATE TLE CMD
+    if (command->cmd == CMD_UPDATE_TLE)
+    {
+        int retval = global->tsys->UpdateTLE(command->TLE1, command->TLE2, command->priority);
+        if (retval > 0)
+        {
+            strcpy(global->TLE1, command->TLE1);
+            strcpy(global->TLE2, command->TLE2);
+            rlogf(LOG_INFO, BLUE_FG "TLE updated to:\n%s\n%s", global->TLE1, global->TLE2);
+        }
+        else if (retval == 0)
         {
-            dbprintlf(BLUE_BG "Waiting to receive...");
-
-            NetFrame *netframe = new NetFrame();
-            read_size = netframe->recvFrame(netdata);
-
-            dbprintlf("Read %d bytes.", read_size);
-
-            if (read_size >= 0)
-            {
-                dbprintlf("Received the following NetFrame:");
-                netframe->print();
-                netframe->printNetstat();
-
-                // Extract the payload into a buffer.
-                // Safe only because recvFrame return PAYLOAD SIZE.
-                int payload_size = netframe->getPayloadSize();
-                unsigned char *payload = (unsigned char *)malloc(payload_size);
-                if (payload == nullptr)
-                {
-                    dbprintlf(FATAL "Memory for payload failed to allocate, packet lost.");
-                    continue;
-                }
-
-                if (netframe->retrievePayload(payload, payload_size) < 0)
-                {
-                    dbprintlf(RED_FG "Error retrieving data.");
-                    if (payload != nullptr)
-                    {
-                        free(payload);
-                        payload = nullptr;
-                    }
-                    continue;
-                }
-
-                switch (netframe->getType())
-                {
-                case NetType::TRACKING_COMMAND:
-                {
-                    dbprintlf(BLUE_FG "Received a TRACKING COMMAND frame.");
-
-                    track_cmd_t *command = (track_cmd_t *) payload;
-                    
-                    // UPDATE TLE CMD
-                    if (command->cmd == CMD_UPDATE_TLE)
-                    {
-                        strcpy(command->TLE1, global->TLE1);
-                        strcpy(command->TLE2, global->TLE2);
-
-                        dbprintlf(BLUE_FG "TLE updated to:\n%s\n%s", global->TLE1, global->TLE2);
-                    }
-
-                    break;
-                }
-                case NetType::ACK:
-                {
-                    dbprintlf(BLUE_FG "Received an ACK frame.");
-                    break;
-                }
-                case NetType::NACK:
-                {
-                    dbprintlf(BLUE_FG "Received a NACK frame.");
-                    break;
-                }
-                default:
-                {
-                }
-                    if (payload != nullptr)
-                    {
-                        free(payload);
-                        payload = nullptr;
-                    }
-                }
-            }
-            else
-            {
-                break;
-            }
-
-            delete netframe;
+            rlogf(LOG_INFO, BLUE_FG "TLE already active.");
         }
-        if (read_size == -404)
+        else if (retval == -3)
         {
-            dbprintlf(RED_BG "Connection forcibly closed by the server.");
-            strcpy(netdata->disconnect_reason, "SERVER-FORCED");
-            netdata->connection_ready = false;
-            continue;
+            rlogf(LOG_WARN, YELLOW_FG "Stale TLE ignored:\n%s\n%s", command->TLE1, command->TLE2);
         }
-        else if (errno == EAGAIN)
+        else
         {
-            dbprintlf(YELLOW_BG "Active connection timed-out (%d).", read_size);
-            strcpy(netdata->disconnect_reason, "TIMED-OUT");
-            netdata->connection_ready = false;
-            continue;
+            rlogf(LOG_ERROR, RED_FG "Invalid TLE received:\n%s\n%s", command->TLE1, command->TLE2);
+            return -1;
         }
-        erprintlf(errno);
     }
+    else if (command->cmd == CMD_REMOVE_TARGET)
+    {
+        if (global->tsys->RemoveTarget(command->target) < 0)
+        {
+            rlogf(LOG_ERROR, RED_FG "Unknown target %d.", command->target);
+            return -1;
+        }
+    }
+    else if (command->cmd == CMD_SET_PRIORITY)
+    {
+        if (global->tsys->SetPriority(command->target, command->priority) < 0)
+        {
+            rlogf(LOG_ERROR, RED_FG "Unknown target %d.", command->target);
+            return -1;
+        }
+    }
+    else
+    {
+        rlogf(LOG_ERROR, RED_FG "Unknown tracking command %d.", command->cmd);
+        return -1;
+    }
+    return 1;
+}
+
+static int rx_ack(global_data_t *global, NetType type, unsigned char *payload, int payload_size)
+{
+    if (global->rx_verbose)
+        rlogf(LOG_DEBUG, BLUE_FG "Received %s frame.", type == NetType::ACK ? "an ACK" : "a NACK");
+    return 1;
+}
+
+static void rx_defaults()
+{
+    rx_handlers[(uint8_t)NetType::TRACKING_COMMAND] = rx_tracking_command;
+    rx_handlers[(uint8_t)NetType::ACK] = rx_ack;
+    rx_handlers[(uint8_t)NetType::NACK] = rx_ack;
+}
 
-    dbprintlf(FATAL "GS_NETWORK_RX_THREAD IS EXITING!");
-    if (global->netdata->thread_status > 0)
+int gs_rx_register(NetType type, rx_handler_t handler)
+{
+    pthread_once(&rx_once, rx_defaults);
+    rx_handlers[(uint8_t)type] = handler;
+    return 1;
+}
+
+void gs_network_rx(void *args, NetFrame *netframe)
+{
+    global_data_t *global = (global_data_t *)args;
+
+    pthread_once(&rx_once, rx_defaults);
+
+    // Only the network engine thread receives, frames are dispatched before the next one is read.
+    static unsigned char payload[NETWORK_FRAME_MAX_PAYLOAD_SIZE];
+
+    if (global->rx_verbose)
+    {
+        rlogf(LOG_DEBUG, "Received the following NetFrame:");
+        netframe->print();
+        netframe->printNetstat();
+    }
+
+    // Safe only because recvFrame return PAYLOAD SIZE.
+    int payload_size = netframe->getPayloadSize();
+    if ((payload_size < 0) || (payload_size > (int)sizeof(payload)))
+    {
+        rlogf(LOG_ERROR, RED_FG "Payload of %d bytes does not fit, packet lost.", payload_size);
+        return;
+    }
+
+    if (netframe->retrievePayload(payload, payload_size) < 0)
+    {
+        rlogf(LOG_ERROR, RED_FG "Error retrieving data.");
+        return;
+    }
+
+    NetType type = netframe->getType();
+    rx_handler_t handler = rx_handlers[(uint8_t)type];
+    if (handler != nullptr)
+        handler(global, type, payload, payload_size);
+    else if (global->rx_verbose)
+        rlogf(LOG_DEBUG, YELLOW_FG "No handler for frame type 0x%x.", (int)type);
+}
+
+void *gs_telemetry_thread(void *args)
+{
+    global_data_t *global = (global_data_t *)args;
+    NetEngine *net = global->net;
+
+    // buffers are sized once, a flush only copies
+    unsigned char payload[NETWORK_FRAME_MAX_PAYLOAD_SIZE];
+    int batch = TelemetryRing::BatchMax(sizeof(payload));
+    if ((global->telem_batch > 0) && (global->telem_batch < batch))
+        batch = global->telem_batch;
+    telem_sample_t *samples = new telem_sample_t[batch];
+    StatsReporter stats;
+    uint64_t stats_due = instr_now() + STATS_PERIOD * 1000000000ULL;
+
+    while (global->telem_active)
     {
-        global->netdata->thread_status = 0;
+        usleep(global->telem_period * 1000);
+        bool connected = net->IsConnected();
+        if ((instr_now() >= stats_due) && connected) // latency histograms since the last report
+        {
+            int payload_size = stats.Pack(payload, sizeof(payload));
+            net->Send(NetType::STATUS, payload, payload_size);
+            stats_due = instr_now() + STATS_PERIOD * 1000000000ULL; // no burst of reports after a disconnect
+        }
+        int count;
+        while ((count = global->tsys->ReadTelemetry(samples, batch)) > 0)
+        {
+            if (!connected) // nobody to send to, keep the ring drained
+                continue;
+            int payload_size = TelemetryRing::Pack(samples, count, global->tsys->TelemetryDropped(), payload, sizeof(payload));
+            if (net->Send(NetType::TRACKING_DATA, payload, payload_size) < 0)
+                break; // queue full or connection lost, try again next period
+        }
     }
-}
\ No newline at end of file
+
+    delete[] samples;
+    return NULL;
+}
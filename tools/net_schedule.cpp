@@ -0,0 +1,117 @@
+/**
+ * @file net_schedule.cpp
+ * @brief Predicts and schedules passes of many targets over every station of the network.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * Usage: net_schedule.out [-s stations] [-e degrees] [-H hours] [-j threads] [-n targets] [-c]
+ *                         <elements>
+ * `elements` is a catalog written by tle_catalog.out or a TLE text file. Stations default to
+ * dish_pos.txt, the elevation mask to 0 degrees and the horizon to 24 hours. -n limits the
+ * number of targets, -c repeats the prediction on one thread and prints the speed-up.
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <math.h>
+#include "StationNetwork.hpp"
+#include "TleCatalog.hpp"
+#include "meb_debug.h"
+
+int main(int argc, char *argv[])
+{
+    const char *station_file = "dish_pos.txt";
+    double el_min = 0, hours = 24;
+    int nthreads = 0, max_targets = 0;
+    bool compare = false;
+    int opt;
+    while ((opt = getopt(argc, argv, "s:e:H:j:n:c")) != -1)
+    {
+        switch (opt)
+        {
+        case 's':
+            station_file = optarg;
+            break;
+        case 'e':
+            el_min = atof(optarg);
+            break;
+        case 'H':
+            hours = atof(optarg);
+            break;
+        case 'j':
+            nthreads = atoi(optarg);
+            break;
+        case 'n':
+            max_targets = atoi(optarg);
+            break;
+        case 'c':
+            compare = true;
+            break;
+        default:
+            optind = argc + 1;
+        }
+    }
+    if (optind != argc - 1)
+    {
+        fprintf(stderr, "Usage: %s [-s stations] [-e degrees] [-H hours] [-j threads] [-n targets] [-c] <elements>\n", argv[0]);
+        return -1;
+    }
+
+    TleCatalog catalog;
+    if (catalog.Open(argv[optind]) < 0)
+    {
+        tle_ingest_t res;
+        if (catalog.Ingest(argv[optind], &res) < 0)
+        {
+            dbprintlf(FATAL "Could not read %s", argv[optind]);
+            return -1;
+        }
+    }
+
+    StationNetwork net;
+    std::vector<station_t> stations;
+    if (StationNetwork::LoadStations(station_file, el_min * M_PI / 180, stations) <= 0)
+    {
+        dbprintlf(FATAL "No stations in %s", station_file);
+        return -1;
+    }
+    for (size_t s = 0; s < stations.size(); s++)
+        net.AddStation(stations[s]);
+    for (size_t i = 0; i < catalog.Size(); i++)
+    {
+        if ((max_targets > 0) && ((int)net.Targets() >= max_targets))
+            break;
+        net.AddTarget(catalog.At(i)->line1, catalog.At(i)->line2);
+    }
+
+    DateTime now = DateTime::Now(true);
+    int windows = net.Predict(now, hours * 3600, nthreads);
+    if (windows < 0)
+    {
+        dbprintlf(FATAL "Nothing to predict");
+        return -1;
+    }
+    for (size_t s = 0; s < net.Stations(); s++)
+    {
+        const station_t &st = net.Station(s);
+        const std::vector<sched_entry_t> &tl = net.Timeline(s);
+        printf("%s (%.4f, %.4f): %zu windows\n", st.name, st.lat, st.lon, tl.size());
+        for (size_t i = 0; i < tl.size(); i++)
+            printf("  %05d  %s  %6.0f s  max el %4.1f\n", tl[i].target, tl[i].start.ToString().c_str(), (tl[i].end - tl[i].start).TotalSeconds(), tl[i].pass.max_el * 180 / M_PI);
+    }
+    network_timing_t tm = net.Timing();
+    double total = tm.propagate + tm.predict + tm.schedule;
+    printf("%zu stations x %zu targets, %d threads: propagate %.3f s, predict %.3f s, schedule %.3f s\n", net.Stations(), net.Targets(), tm.threads, tm.propagate, tm.predict, tm.schedule);
+    if (compare)
+    {
+        net.Predict(now, hours * 3600, 1);
+        network_timing_t one = net.Timing();
+        double total1 = one.propagate + one.predict + one.schedule;
+        printf("1 thread: %.3f s, speed-up %.2fx on %d threads\n", total1, total1 / total, tm.threads);
+    }
+    return 0;
+}
@@ -0,0 +1,155 @@
+/**
+ * @file net_server.cpp
+ * @brief Stand-in for the ground station server on the loopback, for exercising the tracker's
+ * network engine.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * Usage: net_server.out [-p port] [-k seconds]
+ * Accepts one tracker at a time (TRACK_SERVER=127.0.0.1), answers POLL frames with an ACK and
+ * counts the frames it receives by type. With -k the connection is closed every `seconds`, and
+ * the time until the tracker is back is printed.
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include "network.hpp"
+#include "meb_debug.h"
+
+#define SERVER_REPORT 5 // seconds between frame counts
+
+static volatile sig_atomic_t done = 0;
+
+static void sighandler(int sig)
+{
+    done = 1;
+}
+
+static double now_s()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char *argv[])
+{
+    int port = (int)NetPort::TRACK;
+    double kill_period = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "p:k:")) != -1)
+    {
+        if (opt == 'p')
+            port = atoi(optarg);
+        else if (opt == 'k')
+            kill_period = atof(optarg);
+        else
+        {
+            fprintf(stderr, "Usage: %s [-p port] [-k seconds]\n", argv[0]);
+            return -1;
+        }
+    }
+    signal(SIGINT, sighandler);
+    signal(SIGTERM, sighandler);
+    signal(SIGPIPE, SIG_IGN);
+
+    int lfd = socket(AF_INET, SOCK_STREAM, 0);
+    int on = 1;
+    setsockopt(lfd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    struct sockaddr_in addr;
+    memset(&addr, 0x0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if ((bind(lfd, (struct sockaddr *)&addr, sizeof(addr)) < 0) || (listen(lfd, 1) < 0))
+    {
+        dbprintlf(FATAL "Could not listen on port %d: %s", port, strerror(errno));
+        return -1;
+    }
+    printf("Listening on 127.0.0.1:%d\n", port);
+
+    // the connection's socket, NetFrame only needs the descriptor and the ready flag
+    NetDataClient conn(NetPort::TRACK, SERVER_POLL_RATE);
+    conn.socket = -1;
+    conn.connection_ready = false;
+    NetFrame frame;
+    int counts[256] = {0};
+    int connects = 0;
+    double closed_at = 0, opened_at = 0, report_due = now_s() + SERVER_REPORT;
+    while (!done)
+    {
+        struct pollfd pfd;
+        pfd.fd = conn.socket < 0 ? lfd : conn.socket;
+        pfd.events = POLLIN;
+        int ready = poll(&pfd, 1, 100);
+        double now = now_s();
+        if (now >= report_due)
+        {
+            report_due += SERVER_REPORT;
+            printf("%d connects | POLL %d, STATUS %d, TRACKING_DATA %d\n", connects, counts[(uint8_t)NetType::POLL], counts[(uint8_t)NetType::STATUS], counts[(uint8_t)NetType::TRACKING_DATA]);
+            fflush(stdout);
+        }
+        if ((conn.socket >= 0) && (kill_period > 0) && (now - opened_at >= kill_period))
+        {
+            close(conn.socket);
+            conn.socket = -1;
+            conn.connection_ready = false;
+            closed_at = now;
+            continue;
+        }
+        if ((ready <= 0) || !(pfd.revents & (POLLIN | POLLHUP | POLLERR)))
+            continue;
+        if (conn.socket < 0)
+        {
+            conn.socket = accept(lfd, NULL, NULL);
+            if (conn.socket < 0)
+                continue;
+            conn.connection_ready = true;
+            opened_at = now_s();
+            connects++;
+            if (closed_at > 0)
+                printf("Tracker back %.1f ms after the connection was closed\n", (opened_at - closed_at) * 1e3);
+            else
+                printf("Tracker connected\n");
+            fflush(stdout);
+            continue;
+        }
+        int retval = frame.recvFrame(&conn);
+        if (retval < 0)
+        {
+            if ((retval == -404) || (errno == ECONNRESET))
+            {
+                printf("Tracker disconnected\n");
+                close(conn.socket);
+                conn.socket = -1;
+                conn.connection_ready = false;
+                closed_at = 0;
+            }
+            continue;
+        }
+        NetType type = frame.getType();
+        counts[(uint8_t)type]++;
+        if (type == NetType::POLL)
+        {
+            unsigned char ack = 1;
+            NetFrame reply(&ack, sizeof(ack), NetType::ACK, NetVertex::TRACK);
+            reply.sendFrame(&conn);
+        }
+    }
+    if (conn.socket >= 0)
+        close(conn.socket);
+    close(lfd);
+    return 0;
+}
@@ -0,0 +1,394 @@
+/**
+ * @file rotator_emu.cpp
+ * @brief Rotator controller on a pseudo-terminal, for running the tracker without the rotator.
+ * @version See Git tags for version information.
+ * @date 2026.10.17
+ *
+ * Usage: rotator_emu.out [-b baud] [-r az_rate[,el_rate]] [-a accel] [-l latency] [-s spacing]
+ *                        [-m az_min,az_max,el_max] [-o log.csv] [-p period]
+ * Prints the device name to pass to track.out or TargetSystem::Create(). Understands both
+ * dialects of RotatorProtocol.hpp: "PB <az>\r" / "PA <el>\r", and GS-232B "W<aaa> <eee>\r",
+ * "M<aaa>\r" and "C2\r".
+ *
+ * The controller is modelled as the tracker sees it:
+ *   -b  line speed, bytes take 10 bit times each way (default MOTOR_BAUD)
+ *   -r  slew rates in degrees/s (default ROTATOR_AZ_RATE, ROTATOR_EL_RATE)
+ *   -a  acceleration of both axes in degrees/s^2, 0 for instant (default EMU_ACCEL)
+ *   -l  ms from the end of a command line to the axes reacting or the reply going out
+ *       (default EMU_LATENCY)
+ *   -s  ms within which a second setpoint for the same axis is dropped (default
+ *       MOTOR_CMD_SPACING)
+ *   -m  mechanical range in degrees, setpoints outside it are rejected (default ROTATOR_AZ_MIN,
+ *       ROTATOR_AZ_MAX, ROTATOR_EL_MAX)
+ *   -o  log the commanded and the actual position every -p ms (default EMU_LOG_PERIOD) as CSV;
+ *       time_us is microseconds since the Unix epoch, as in the tracker's telemetry, so the two
+ *       join on time for the pointing error against the prediction
+ * Activity is split into segments at EMU_SEGMENT_GAP seconds without a setpoint, one per pass;
+ * each ends with a line of command throughput and of following error (commanded against actual).
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <math.h>
+#include <poll.h>
+#include <signal.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <deque>
+#include "TrackingMotor.hpp"
+#include "meb_debug.h"
+
+#define EMU_STEP 10         // ms between updates of the dish position
+#define EMU_ACCEL 10.0      // degrees/s^2
+#define EMU_LATENCY 50      // ms
+#define EMU_LOG_PERIOD 100  // ms
+#define EMU_SEGMENT_GAP 30  // seconds without a setpoint that end a segment
+#define EMU_SETTLE_ERROR 1  // degrees, following error counted as off target beyond this
+
+/**
+ * @brief One axis: where it is, how fast it goes, and where it was told to go.
+ *
+ */
+typedef struct
+{
+    double pos;   // degrees
+    double vel;   // degrees/s
+    double cmd;   // degrees, setpoint in effect
+    double rate;  // degrees/s, slew limit
+    double accel; // degrees/s^2, 0 for instant
+    double last;  // seconds, when the last setpoint for this axis arrived
+} emu_axis_t;
+
+/**
+ * @brief Something the controller will do once its latency has passed.
+ *
+ */
+typedef struct
+{
+    double due;  // seconds
+    int mask;    // MOTOR_AXIS_*, setpoints to apply
+    double az;   // degrees
+    double el;   // degrees
+    bool report; // send a position report
+} emu_action_t;
+
+/**
+ * @brief Commands and following error over one segment of activity.
+ *
+ */
+typedef struct
+{
+    double start;    // seconds
+    double end;      // seconds, last setpoint
+    long setpoints;  // accepted
+    long dropped;    // too soon after the previous one
+    long rejected;   // outside the mechanical range
+    long queries;    // position reports sent
+    long samples;    // following error samples
+    double sum_err2; // degrees^2
+    double max_err;  // degrees
+    long off_target; // samples beyond EMU_SETTLE_ERROR
+} emu_segment_t;
+
+static volatile sig_atomic_t done = 0;
+
+static void sighandler(int sig)
+{
+    done = 1;
+}
+
+static double now_s()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int64_t unix_us()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+/**
+ * @brief Advance one axis by `dt` seconds: accelerate toward the setpoint up to the slew rate,
+ * and brake in time to stop on it.
+ *
+ */
+static void axis_step(emu_axis_t *ax, double dt)
+{
+    double d = ax->cmd - ax->pos;
+    if (ax->accel <= 0)
+    {
+        ax->vel = copysign(std::min(fabs(d) / dt, ax->rate), d);
+        ax->pos += ax->vel * dt;
+        return;
+    }
+    double want = copysign(std::min(ax->rate, sqrt(2 * ax->accel * fabs(d))), d); // fastest we can still stop from
+    double dv = want - ax->vel;
+    ax->vel += copysign(std::min(fabs(dv), ax->accel * dt), dv);
+    double next = ax->pos + ax->vel * dt;
+    if ((ax->cmd - next) * d <= 0) // reached or passed the setpoint
+    {
+        ax->pos = ax->cmd;
+        ax->vel = 0;
+    }
+    else
+        ax->pos = next;
+}
+
+static void segment_report(const emu_segment_t &s)
+{
+    double len = s.end - s.start;
+    printf("Segment %6.1f s: %ld setpoints (%.2f/s), %ld dropped, %ld rejected, %ld reports; following error rms %.2f max %.2f degrees, %.1f%% beyond %d\n", len, s.setpoints, len > 0 ? s.setpoints / len : 0, s.dropped, s.rejected, s.queries, s.samples > 0 ? sqrt(s.sum_err2 / s.samples) : 0, s.max_err, s.samples > 0 ? 100.0 * s.off_target / s.samples : 0, EMU_SETTLE_ERROR);
+    fflush(stdout);
+}
+
+int main(int argc, char *argv[])
+{
+    int baud = MOTOR_BAUD;
+    double az_rate = ROTATOR_AZ_RATE, el_rate = ROTATOR_EL_RATE, accel = EMU_ACCEL;
+    double latency = EMU_LATENCY * 1e-3, spacing = MOTOR_CMD_SPACING;
+    double az_min = ROTATOR_AZ_MIN, az_max = ROTATOR_AZ_MAX, el_max = ROTATOR_EL_MAX;
+    double log_period = EMU_LOG_PERIOD * 1e-3;
+    const char *log_name = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "b:r:a:l:s:m:o:p:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'b':
+            baud = atoi(optarg);
+            break;
+        case 'r':
+            if (sscanf(optarg, "%lf,%lf", &az_rate, &el_rate) == 1)
+                el_rate = az_rate;
+            break;
+        case 'a':
+            accel = atof(optarg);
+            break;
+        case 'l':
+            latency = atof(optarg) * 1e-3;
+            break;
+        case 's':
+            spacing = atof(optarg) * 1e-3;
+            break;
+        case 'm':
+            sscanf(optarg, "%lf,%lf,%lf", &az_min, &az_max, &el_max);
+            break;
+        case 'o':
+            log_name = optarg;
+            break;
+        case 'p':
+            log_period = atof(optarg) * 1e-3;
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-b baud] [-r az_rate[,el_rate]] [-a accel] [-l latency] [-s spacing] [-m az_min,az_max,el_max] [-o log.csv] [-p period]\n", argv[0]);
+            return -1;
+        }
+    }
+    if ((baud <= 0) || (az_rate <= 0) || (el_rate <= 0) || (accel < 0) || (latency < 0) || (spacing < 0) || (log_period <= 0))
+    {
+        dbprintlf(FATAL "Invalid model parameters");
+        return -1;
+    }
+    double char_time = 10.0 / baud; // start, 8 data bits and stop
+
+    signal(SIGINT, sighandler);
+    signal(SIGTERM, sighandler);
+
+    FILE *csv = NULL;
+    if (log_name != NULL)
+    {
+        csv = fopen(log_name, "w");
+        if (csv == NULL)
+        {
+            dbprintlf(FATAL "Could not open %s", log_name);
+            return -1;
+        }
+        fprintf(csv, "time_us,cmd_az,cmd_el,az,el,az_rate,el_rate\n");
+    }
+
+    int master = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if ((master < 0) || (grantpt(master) < 0) || (unlockpt(master) < 0))
+    {
+        dbprintlf(FATAL "Could not open a pseudo-terminal");
+        return -1;
+    }
+    // hold the slave open so the line does not hang up between clients, and keep it raw
+    int slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+    if (slave < 0)
+    {
+        dbprintlf(FATAL "Could not open %s", ptsname(master));
+        return -1;
+    }
+    struct termios tio;
+    tcgetattr(slave, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(slave, TCSANOW, &tio);
+    printf("%s\n", ptsname(master));
+    fflush(stdout);
+
+    emu_axis_t az = {0, 0, 0, az_rate, accel, -1e9};
+    emu_axis_t el = {90, 0, 90, el_rate, accel, -1e9};
+    std::deque<char> rx;          // received, not yet through the line
+    std::deque<emu_action_t> todo; // waiting out the latency, in order
+    double rx_clock = 0;          // when the last byte taken from rx finished arriving
+    double tx_clock = 0;          // when the line is free to send again
+    char line[ROTATOR_LINE_MAX];
+    int len = 0;
+    emu_segment_t seg;
+    memset(&seg, 0x0, sizeof(seg));
+    bool active = false;
+    double last = now_s(), next_log = last, next_sample = last;
+    while (!done)
+    {
+        struct pollfd pfd = {master, POLLIN, 0};
+        int ready = poll(&pfd, 1, EMU_STEP);
+        double now = now_s();
+        if ((ready > 0) && (pfd.revents & POLLIN))
+        {
+            char buf[256];
+            int n = read(master, buf, sizeof(buf));
+            if ((n > 0) && rx.empty())
+                rx_clock = std::max(rx_clock, now - char_time); // the line was idle, bytes start now
+            for (int i = 0; i < n; i++)
+                rx.push_back(buf[i]);
+        }
+        // bytes come off the line one character time apart
+        while (!rx.empty() && (rx_clock + char_time <= now))
+        {
+            rx_clock += char_time;
+            char c = rx.front();
+            rx.pop_front();
+            if ((c != '\r') && (c != '\n'))
+            {
+                if (len < ROTATOR_LINE_MAX - 1)
+                    line[len++] = c;
+                continue;
+            }
+            line[len] = '\0';
+            len = 0;
+            emu_action_t act = {rx_clock + latency, 0, az.cmd, el.cmd, false};
+            int a, e;
+            if (sscanf(line, "PB %d", &a) == 1)
+            {
+                act.mask = MOTOR_AXIS_AZ;
+                act.az = a;
+            }
+            else if (sscanf(line, "PA %d", &e) == 1)
+            {
+                act.mask = MOTOR_AXIS_EL;
+                act.el = e;
+            }
+            else if (sscanf(line, "W%d %d", &a, &e) == 2)
+            {
+                act.mask = MOTOR_AXIS_AZ | MOTOR_AXIS_EL;
+                act.az = a;
+                act.el = e;
+            }
+            else if (sscanf(line, "M%d", &a) == 1)
+            {
+                act.mask = MOTOR_AXIS_AZ;
+                act.az = a;
+            }
+            else if (strcmp(line, "C2") == 0)
+                act.report = true;
+            else
+                continue;
+            if (act.mask != 0)
+            {
+                if (!active)
+                {
+                    memset(&seg, 0x0, sizeof(seg));
+                    seg.start = rx_clock;
+                    active = true;
+                }
+                seg.end = rx_clock;
+                if (((act.mask & MOTOR_AXIS_AZ) && ((act.az < az_min) || (act.az > az_max))) || ((act.mask & MOTOR_AXIS_EL) && ((act.el < 0) || (act.el > el_max))))
+                {
+                    seg.rejected++;
+                    continue;
+                }
+                if (((act.mask & MOTOR_AXIS_AZ) && (rx_clock - az.last < spacing)) || ((act.mask & MOTOR_AXIS_EL) && (rx_clock - el.last < spacing)))
+                {
+                    seg.dropped++;
+                    continue;
+                }
+                if (act.mask & MOTOR_AXIS_AZ)
+                    az.last = rx_clock;
+                if (act.mask & MOTOR_AXIS_EL)
+                    el.last = rx_clock;
+                seg.setpoints++;
+            }
+            todo.push_back(act);
+        }
+        // move in small steps, applying setpoints and sending reports as they fall due
+        while (last < now)
+        {
+            double step = std::min(now - last, EMU_STEP * 1e-3);
+            if (!todo.empty() && (todo.front().due < last + step))
+                step = std::max(todo.front().due - last, 0.0);
+            axis_step(&az, step);
+            axis_step(&el, step);
+            last += step;
+            while (!todo.empty() && (todo.front().due <= last))
+            {
+                emu_action_t act = todo.front();
+                todo.pop_front();
+                if (act.mask & MOTOR_AXIS_AZ)
+                    az.cmd = act.az;
+                if (act.mask & MOTOR_AXIS_EL)
+                    el.cmd = act.el;
+                if (act.report)
+                {
+                    char reply[32];
+                    int sz = snprintf(reply, sizeof(reply), "AZ=%03d  EL=%03d\r\n", (int)round(az.pos), (int)round(el.pos));
+                    tx_clock = std::max(tx_clock, last) + sz * char_time;
+                    double wait = tx_clock - now_s();
+                    if (wait > 0) // the reply is on the line until its last byte is through
+                        usleep(wait * 1e6);
+                    if (write(master, reply, sz) != sz)
+                        dbprintlf(YELLOW_FG "Short write of a position report");
+                    if (active)
+                        seg.queries++;
+                }
+            }
+        }
+        if (active && (now >= next_sample)) // evenly spaced, however busy the line is
+        {
+            next_sample = now + EMU_STEP * 1e-3;
+            double err = rotator_distance(az.cmd, el.cmd, az.pos, el.pos);
+            seg.samples++;
+            seg.sum_err2 += err * err;
+            seg.max_err = std::max(seg.max_err, err);
+            if (err > EMU_SETTLE_ERROR)
+                seg.off_target++;
+            if (now - seg.end > EMU_SEGMENT_GAP)
+            {
+                segment_report(seg);
+                active = false;
+            }
+        }
+        if ((csv != NULL) && (now >= next_log))
+        {
+            fprintf(csv, "%ld,%.0f,%.0f,%.3f,%.3f,%.3f,%.3f\n", (long)unix_us(), az.cmd, el.cmd, az.pos, el.pos, az.vel, el.vel);
+            next_log += log_period * std::max(1.0, ceil((now - next_log) / log_period));
+        }
+    }
+    if (active)
+        segment_report(seg);
+    if (csv != NULL)
+        fclose(csv);
+    close(slave);
+    close(master);
+    return 0;
+}